@@ -0,0 +1,434 @@
+// benchmarks for delimited_output. each case is run a number of times and the
+// best time per run is reported; output goes to a stream that discards it so
+// that formatting rather than I/O is measured.
+
+#include "delimited_output.hpp"
+#include "delimited_async.hpp"
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <variant>
+#include <deque>
+#include <array>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+using namespace delimited_output;
+
+// streambuf that discards (but counts) its output
+class null_buf: public std::streambuf {
+public:
+    std::size_t count = 0;
+protected:
+    int_type overflow(int_type c) override {++count; return traits_type::not_eof(c);}
+    std::streamsize xsputn(const char_type*, std::streamsize n) override {count += n; return n;}
+};
+
+// reference implementation of the recursive, run-time dispatched traversal
+// that the format plan replaced (as_sub is tested for every element)
+namespace recursive {
+
+template <typename T>
+void output(const T& x, const delimiters&, bool, std::ostream& out) {out << x;}
+
+inline void output(const std::string& str, const delimiters& delims, bool, std::ostream& out)
+{if (str.size()) out << str; else out << delims.empty;}
+
+template <typename T1, typename T2>
+void output(const std::pair<T1, T2>& pair, const delimiters& delims, bool as_sub, std::ostream& out);
+
+template <std::ranges::range T> requires (!std::same_as<T, std::string>)
+void output(const T& range, const delimiters& delims, bool as_sub, std::ostream& out);
+
+template <typename T1, typename T2>
+void output(const std::pair<T1, T2>& pair, const delimiters& delims, bool as_sub, std::ostream& out) {
+    if (as_sub)
+        out << delims.pair_prefix;
+    output(pair.first, delims, true, out);
+    out << delims.pair_delim;
+    output(pair.second, delims, true, out);
+    if (as_sub)
+        out << delims.pair_suffix;
+}
+
+template <std::ranges::range T> requires (!std::same_as<T, std::string>)
+void output(const T& range, const delimiters& delims, bool as_sub, std::ostream& out) {
+    if (as_sub)
+        out << delims.sub_prefix;
+    auto itr = range.begin();
+    auto end = range.end();
+    if (itr == end)
+        out << delims.empty;
+    else {
+        output(*itr, delims, true, out);
+        auto delim = as_sub ? delims.sub_delim : delims.top_delim;
+        while (++itr != end) {
+            out << delim;
+            output(*itr, delims, true, out);
+        }
+    }
+    if (as_sub)
+        out << delims.sub_suffix;
+}
+
+} // namespace recursive
+
+double best_ms(int runs, const std::function<void()>& f) {
+    auto best = std::chrono::duration<double, std::milli>::max();
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start));
+    }
+    return best.count();
+}
+
+void report(const char* name, double ms) {
+    std::cout << name << ": " << ms << " ms\n";
+}
+
+template <typename T>
+void compare(const char* name, const T& obj, int runs = 10) {
+    null_buf buf;
+    std::ostream out{&buf};
+    auto delims = delimiters{};
+    std::cout << name << '\n';
+    report("  recursive dispatch", best_ms(runs, [&] {recursive::output(obj, delims, false, out);}));
+    report("  format plan       ", best_ms(runs, [&] {out << delimited(obj, delims);}));
+}
+
+template <typename T>
+void compare_prefetch(const char* name, const T& obj, int runs = 5) {
+    null_buf buf;
+    std::ostream out{&buf};
+    std::cout << name << '\n';
+    for (std::size_t distance: {0, 2, 4, 8, 16}) {
+        auto label = "  prefetch(" + std::to_string(distance) + ")";
+        report(label.c_str(), best_ms(runs, [&] {out << delimited(obj).prefetch(distance);}));
+    }
+}
+
+// time spent on the calling thread writing records, formatted synchronously and
+// written to an async sink (which formats them on its own thread)
+template <typename T>
+void compare_async(const char* name, const std::vector<T>& records, int runs = 10) {
+    null_buf buf;
+    std::ostream out{&buf};
+    std::cout << name << '\n';
+    report("  delimited()      ", best_ms(runs, [&] {
+        for (const auto& record: records)
+            out << delimited(record) << '\n';
+    }));
+    auto sink = async_sink{out, std::size_t{1} << 26};
+    auto best = std::chrono::duration<double, std::milli>::max();
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& record: records)
+            sink.write(record);
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start));
+        sink.flush(); // (not timed)
+    }
+    report("  async_sink::write", best.count());
+}
+
+// total time for a number of threads to write records to one stream, with a
+// mutex around the stream and through a shared sink
+template <typename T>
+void compare_shared(const char* name, const std::vector<T>& records, int threads, int runs = 5) {
+    null_buf buf;
+    std::ostream out{&buf};
+    auto run_threads = [&](auto write) {
+        auto pool = std::vector<std::thread>{};
+        for (int t = 0; t < threads; ++t)
+            pool.emplace_back([&, t] {
+                for (std::size_t i = t; i < records.size(); i += threads)
+                    write(records[i]);
+            });
+        for (auto& thread: pool)
+            thread.join();
+    };
+    std::cout << name << '\n';
+    std::mutex mutex;
+    report("  mutex around stream", best_ms(runs, [&] {
+        run_threads([&](const T& record) {
+            auto lock = std::lock_guard{mutex};
+            out << delimited(record) << '\n';
+        });
+    }));
+    auto sink = shared_sink{out, std::size_t{1} << 25};
+    report("  shared_sink        ", best_ms(runs, [&] {
+        run_threads([&](const T& record) {sink.write(record);});
+        sink.flush();
+    }));
+}
+
+} // namespace
+
+int main() {
+    {
+        auto vectors = std::vector<std::vector<std::vector<int>>>(200, std::vector<std::vector<int>>(100));
+        int n = 0;
+        for (auto& v: vectors)
+            for (auto& w: v)
+                for (int i = 0; i < 10; ++i)
+                    w.push_back(n++);
+        compare("vector<vector<vector<int>>> (200 x 100 x 10)", vectors);
+    }
+    {
+        auto vectors = std::vector<std::vector<std::vector<int>>>(20000, std::vector<std::vector<int>>(10, std::vector<int>(1, 7)));
+        compare("vector<vector<vector<int>>> (20000 x 10 x 1)", vectors);
+    }
+    {
+        auto maps = std::vector<std::map<int, std::vector<std::string>>>(1000);
+        int n = 0;
+        for (auto& m: maps)
+            for (int i = 0; i < 20; ++i)
+                m[n++] = {"alpha", "beta", "", "gamma"};
+        compare("vector<map<int, vector<string>>> (1000 x 20 x 4)", maps);
+    }
+    {
+        auto ints = std::deque<int>{};
+        auto strs = std::deque<std::string>{};
+        for (int i = 0; i < 1'000'000; ++i) {
+            ints.push_back(i * 7);
+            strs.push_back("item" + std::to_string(i));
+        }
+        compare("deque<int> (1M)", ints);
+        compare("deque<string> (1M)", strs);
+        compare("vector<double> (1M)", std::vector<double>(ints.begin(), ints.end()));
+    }
+    {
+        // inserted in random order so that the nodes are scattered in memory
+        auto keys = std::vector<int>(2'000'000);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+        auto a_map = std::map<int, std::string>{};
+        for (auto key: keys)
+            a_map.emplace(key, "value");
+        compare_prefetch("map<int, string> (2M entries)", a_map);
+    }
+    {
+        auto records = std::vector<std::map<int, std::string>>(10000);
+        int n = 0;
+        for (auto& record: records)
+            for (int i = 0; i < 10; ++i, ++n)
+                record[n] = "value" + std::to_string(n);
+        compare_async("map<int, string> records (10000 x 10)", records);
+        auto doubles = std::vector<std::vector<double>>(10000, std::vector<double>(10, 1.0 / 3));
+        compare_async("vector<double> records (10000 x 10)", doubles);
+    }
+    {
+        auto records = std::vector<std::map<int, std::string>>(100000);
+        int n = 0;
+        for (auto& record: records)
+            for (int i = 0; i < 10; ++i, ++n)
+                record[n] = "value" + std::to_string(n);
+        compare_shared("map<int, string> records (100000 x 10), 4 threads", records, 4);
+    }
+    {
+        auto rows = std::vector<std::tuple<int, std::string, double>>{};
+        for (int i = 0; i < 100'000; ++i)
+            rows.emplace_back(i, "name" + std::to_string(i % 997), i / 7.0);
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "vector<tuple<int, string, double>> (100000)\n";
+        report("  delimited()      ", best_ms(5, [&] {out << delimited(rows);}));
+        report("  delimited().table", best_ms(5, [&] {out << delimited(rows).table();}));
+    }
+    {
+        auto config = std::map<std::string, std::string>{};
+        for (int i = 0; i < 1000; ++i)
+            config["key" + std::to_string(i)] = "value" + std::to_string(i * 31);
+        null_buf buf;
+        std::ostream out{&buf};
+        auto cache = delimited_cache{};
+        std::cout << "map<string, string> (1000), output 100 times\n";
+        report("  delimited()       ", best_ms(5, [&] {for (int i = 0; i < 100; ++i) out << delimited(config);}));
+        report("  cached_delimited()", best_ms(5, [&] {for (int i = 0; i < 100; ++i) out << cached_delimited(cache, config, 1);}));
+    }
+    {
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "vector<int> grown to 100000, 1000 at a time, output after each\n";
+        report("  delimited()         ", best_ms(3, [&] {
+            auto values = std::vector<int>{};
+            for (int i = 0; i < 100'000; ++i)
+                if (values.push_back(i); values.size() % 1000 == 0)
+                    out << delimited(values);
+        }));
+        report("  delimited_appender{}", best_ms(3, [&] {
+            auto values = std::vector<int>{};
+            auto appender = delimited_appender{};
+            for (int i = 0; i < 100'000; ++i)
+                if (values.push_back(i); values.size() % 1000 == 0)
+                    out << appender(values);
+        }));
+    }
+    {
+        auto before = std::vector<int>(1'000'000);
+        for (int i = 0; i < 1'000'000; ++i)
+            before[i] = i;
+        auto after = before;
+        after[123'456] = -1;
+        auto map_before = std::map<int, std::string>{};
+        for (int i = 0; i < 100'000; ++i)
+            map_before[i] = std::to_string(i);
+        auto map_after = map_before;
+        map_after[50'000] = "changed";
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "vector<int> (1M), one element changed\n";
+        report("  delimited() x 2 ", best_ms(5, [&] {out << delimited(before) << delimited(after);}));
+        report("  delimited_diff()", best_ms(5, [&] {out << delimited_diff(before, after);}));
+        std::cout << "map<int, string> (100000), one value changed\n";
+        report("  delimited() x 2 ", best_ms(5, [&] {out << delimited(map_before) << delimited(map_after);}));
+        report("  delimited_diff()", best_ms(5, [&] {out << delimited_diff(map_before, map_after);}));
+    }
+    {
+        auto ids = std::unordered_map<std::uint32_t, std::string>{};
+        auto names = std::unordered_map<std::string, std::uint64_t>{};
+        for (std::uint64_t i = 0; i < 200'000; ++i) {
+            ids[std::uint32_t(i * 2654435761u)] = std::string(100, 'x');
+            names[std::to_string(i * 2654435761u)] = i;
+        }
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "unordered_map<uint32_t, string> (200000)\n";
+        report("  delimited()           ", best_ms(5, [&] {out << delimited(ids);}));
+        report("  delimited().sorted()  ", best_ms(5, [&] {out << delimited(ids).sorted();}));
+        report("  delimited().sorted(10)", best_ms(5, [&] {out << delimited(ids).sorted(10);}));
+        std::cout << "unordered_map<string, uint64_t> (200000)\n";
+        report("  delimited()           ", best_ms(5, [&] {out << delimited(names);}));
+        report("  delimited().sorted()  ", best_ms(5, [&] {out << delimited(names).sorted();}));
+    }
+    {
+        auto values = std::vector<std::variant<int, double, std::string>>{};
+        for (int i = 0; i < 300'000; ++i)
+            if (i % 3 == 0)
+                values.emplace_back(i);
+            else if (i % 3 == 1)
+                values.emplace_back(i / 4.0);
+            else
+                values.emplace_back(std::to_string(i));
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "vector<variant<int, double, string>> (300000)\n";
+        report("  std::visit loop", best_ms(5, [&] {
+            bool first = true;
+            for (const auto& v: values) {
+                if (!first)
+                    out << ", ";
+                first = false;
+                std::visit([&](const auto& x) {out << x;}, v);
+            }
+        }));
+        report("  delimited()     ", best_ms(5, [&] {out << delimited(values);}));
+    }
+    {
+        struct trade {
+            int id;
+            double price;
+            std::string symbol;
+        };
+        auto trades = std::vector<trade>{};
+        for (int i = 0; i < 300'000; ++i)
+            trades.push_back({i, i / 8.0, "SYM" + std::to_string(i % 100)});
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "vector<trade> (300000), trade an aggregate of int, double, string\n";
+        report("  hand-written operator<<", best_ms(5, [&] {
+            bool first = true;
+            for (const auto& t: trades) {
+                if (!first)
+                    out << ", ";
+                first = false;
+                out << '(' << t.id << ", " << t.price << ", " << t.symbol << ')';
+            }
+        }));
+        report("  delimited()            ", best_ms(5, [&] {out << delimited(trades);}));
+    }
+    {
+        auto positions = std::vector<std::array<double, 3>>(100'000);
+        auto ids = std::vector<std::array<std::uint8_t, 16>>(100'000);
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            positions[i] = {i * 0.5, i * -0.25, i / 3.0};
+            for (std::size_t j = 0; j < 16; ++j)
+                ids[i][j] = std::uint8_t('a' + (i + j) % 26);
+        }
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "array<double, 3> (100000 outputs)\n";
+        report("  element loop", best_ms(5, [&] {for (const auto& p: positions) out << p[0] << ", " << p[1] << ", " << p[2];}));
+        report("  delimited() ", best_ms(5, [&] {for (const auto& p: positions) out << delimited(p);}));
+        std::cout << "array<uint8_t, 16> (100000 outputs)\n";
+        report("  element loop", best_ms(5, [&] {
+            for (const auto& id: ids)
+                for (std::size_t j = 0; j < 16; ++j)
+                    out << (j ? ", " : "") << id[j];
+        }));
+        report("  delimited() ", best_ms(5, [&] {for (const auto& id: ids) out << delimited(id);}));
+    }
+    {
+        auto readings = std::map<int, double>{};
+        for (int i = 0; i < 100'000; ++i)
+            readings[i] = i / 7.0;
+        char payload[512];
+        std::cout << "map<int, double> (100000) into a 512-byte payload\n";
+        report("  stringstream and cut  ", best_ms(5, [&] {
+            std::ostringstream text;
+            text << delimited(readings);
+            auto str = text.str();
+            std::memcpy(payload, str.data(), std::min(str.size(), sizeof payload));
+        }));
+        report("  delimited_format_to_n()", best_ms(5, [&] {delimited_format_to_n(payload, sizeof payload, readings);}));
+    }
+    {
+        auto levels = std::vector<int>(32);
+        for (int i = 0; i < 32; ++i)
+            levels[i] = i * 1000;
+        std::size_t total = 0;
+        std::cout << "vector<int> (32) formatted to a string (100000 ticks)\n";
+        report("  ostringstream         ", best_ms(5, [&] {
+            for (int tick = 0; tick < 100'000; ++tick) {
+                std::ostringstream text;
+                text << delimited(levels);
+                total += text.str().size();
+            }
+        }));
+        report("  delimited_formatter<> ", best_ms(5, [&] {
+            auto formatter = delimited_formatter<std::vector<int>>{};
+            for (int tick = 0; tick < 100'000; ++tick)
+                total += formatter.format(levels).size();
+        }));
+        if (!total)
+            std::cout << '\n';
+    }
+    {
+        auto levels = std::vector<int>(64);
+        auto states = std::map<int, std::string>{};
+        for (int i = 0; i < 64; ++i) {
+            levels[i] = i * 1000;
+            states[i] = "idle";
+        }
+        null_buf buf;
+        std::ostream out{&buf};
+        std::cout << "unchanged state (100000 outputs)\n";
+        auto last_levels = delimited_last_output{}, last_states = delimited_last_output{};
+        report("  vector<int> (64), delimited()                   ", best_ms(5, [&] {for (int i = 0; i < 100'000; ++i) out << delimited(levels);}));
+        report("  vector<int> (64), delimited_if_changed()        ", best_ms(5, [&] {for (int i = 0; i < 100'000; ++i) delimited_if_changed(last_levels, out, levels);}));
+        report("  map<int, string> (64), delimited()              ", best_ms(5, [&] {for (int i = 0; i < 100'000; ++i) out << delimited(states);}));
+        report("  map<int, string> (64), delimited_if_changed()   ", best_ms(5, [&] {for (int i = 0; i < 100'000; ++i) delimited_if_changed(last_states, out, states);}));
+    }
+}
@@ -0,0 +1,52 @@
+// translation unit used by the compile-bench target in the Makefile to
+// measure the build-time and code-size effect of DELIMITED_OUTPUT_EXTERN_TEMPLATES
+// (i.e., of using the instantiations in libdelimited_output.a instead of
+// instantiating them here). it outputs a typical mix of the common types.
+
+#include "delimited_output.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <string>
+#include <string_view>
+
+template <typename V>
+void output_all(std::ostream& out, const V& v) {
+    using namespace delimited_output;
+    out << delimited(std::vector<V>{v, v}) << '\n';
+    out << delimited(std::map<int, V>{{1, v}}) << '\n';
+    out << delimited(std::map<long, V>{{2, v}}) << '\n';
+    out << delimited(std::map<std::string, V>{{"three", v}}) << '\n';
+    out << delimited(std::pair<int, V>{4, v}) << '\n';
+    out << delimited(std::pair<std::string, V>{"five", v}) << '\n';
+    out << delimited(std::tuple<long, V>{6, v}) << '\n';
+}
+
+template <typename V>
+void woutput_all(std::wostream& out, const V& v) {
+    using namespace delimited_output;
+    out << wdelimited(std::vector<V>{v, v}) << L'\n';
+    out << wdelimited(std::map<int, V>{{1, v}}) << L'\n';
+    out << wdelimited(std::map<std::wstring, V>{{L"three", v}}) << L'\n';
+    out << wdelimited(std::pair<long, V>{4, v}) << L'\n';
+    out << wdelimited(std::tuple<int, V>{6, v}) << L'\n';
+}
+
+int main() {
+    std::ostringstream out;
+    output_all(out, 1);
+    output_all(out, 2L);
+    output_all(out, 3.5);
+    output_all(out, std::string{"string"});
+    output_all(out, std::string_view{"string_view"});
+    std::wostringstream wout;
+    woutput_all(wout, 1);
+    woutput_all(wout, 2L);
+    woutput_all(wout, 3.5);
+    woutput_all(wout, std::wstring{L"wstring"});
+    woutput_all(wout, std::wstring_view{L"wstring_view"});
+    std::cout << out.str().size() + wout.str().size() << " characters output\n";
+}
@@ -0,0 +1,655 @@
+#ifndef DELIMITED_ASYNC_HPP
+#define DELIMITED_ASYNC_HPP
+
+#include "delimited_output.hpp"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace delimited_output {
+
+// basic_async_sink, async_sink, wasync_sink:
+
+// An async sink outputs objects to a stream as delimited() does, but with the
+// formatting and I/O done by a background thread; for example:
+//    auto sink = async_sink{std::cout};
+//    sink.write(a_map);          // outputs a_map, then a newline
+//    sink.write(tups, delims);
+// write() copies a compact binary snapshot of the object (its arithmetic values
+// and string characters, plus element counts for ranges) into a lock-free ring
+// buffer owned by the calling thread, along with a pointer to the function that
+// formats that type of snapshot, so the calling thread does no formatting. The
+// background thread outputs snapshots with the same format plan as delimited(),
+// so the output is the same, except that it's formatted with the formatting
+// state (precision, etc.) of the sink's stream.
+
+// Only objects whose leaves (what's left after pairs, tuples and ranges are
+// taken apart) are arithmetic values or strings can be written, and ranges must
+// be forward ranges that can be iterated as const. Delimiters are copied, but
+// the strings they refer to must outlive the sink (string literals do). The
+// records written by a thread are output in order; the records of different
+// threads are interleaved record by record. While a thread's ring buffer is
+// full, write() waits for it to be drained; an object whose snapshot can't fit
+// in the ring buffer at all is rejected with std::length_error. flush() waits
+// until everything written before it has been output and the stream flushed;
+// the destructor does likewise (so must not be run while other threads may
+// still write). A ring buffer is allocated for each thread that writes to a
+// sink and kept for the life of the sink.
+
+template <typename CharT, typename Traits = std::char_traits<CharT>> class basic_async_sink;
+
+using async_sink = basic_async_sink<char>;
+using wasync_sink = basic_async_sink<wchar_t>;
+
+// basic_shared_sink, shared_sink, wshared_sink:
+
+// A shared sink lets many threads output objects (as delimited() does) to one
+// stream without a mutex and without their output interleaving; for example:
+//    auto sink = shared_sink{std::cout};
+//    sink.write(a_map);          // outputs a_map, then a newline
+// write() formats the object on the calling thread into a thread-local buffer,
+// then reserves space for the text in a ring buffer shared by all the writing
+// threads by advancing a reservation counter with a single atomic add, copies
+// the text into it and publishes it; a background thread outputs the published
+// text to the stream in reservation order. Since records are published in that
+// order, a writer whose text has been copied may wait briefly for the writers
+// that reserved space before it to finish copying theirs. Any object can be
+// written (the same as with delimited(), including the helper object that
+// delimited() returns), and the text is formatted with default formatting
+// state. While the ring buffer is full, write() waits for it to be drained; a
+// record larger than the ring buffer is rejected with std::length_error.
+// flush() and the destructor are as for an async sink.
+
+template <typename CharT, typename Traits = std::char_traits<CharT>> class basic_shared_sink;
+
+using shared_sink = basic_shared_sink<char>;
+using wshared_sink = basic_shared_sink<wchar_t>;
+
+namespace helpers {
+
+// snapshots:
+
+// snapshot<T, CharT, Traits> encodes a T into bytes and decodes the bytes into
+// a "replayed" object that the format plan outputs the same way as the T (e.g.,
+// a vector<pair<int, string>> is replayed as a range of pair<int, string_view>);
+// positions are offsets from a base that is aligned for any leaf type.
+
+constexpr std::size_t align_up(std::size_t pos, std::size_t alignment) noexcept
+{return (pos + alignment - 1) & ~(alignment - 1);}
+
+template <typename T>
+constexpr std::size_t raw_size(std::size_t pos) noexcept
+{return align_up(pos, alignof(T)) + sizeof(T);}
+
+template <typename T>
+inline void put_raw(std::byte* base, std::size_t& pos, const T& x) noexcept {
+    pos = align_up(pos, alignof(T));
+    std::memcpy(base + pos, &x, sizeof(T));
+    pos += sizeof(T);
+}
+
+template <typename T>
+inline T get_raw(const std::byte* base, std::size_t& pos) noexcept {
+    pos = align_up(pos, alignof(T));
+    T x;
+    std::memcpy(&x, base + pos, sizeof(T));
+    pos += sizeof(T);
+    return x;
+}
+
+template <typename T, typename CharT, typename Traits, plan_kind = plan<T, CharT, Traits>::kind>
+struct snapshot; // (undefined for types that can't be snapshotted)
+
+template <typename T, typename CharT, typename Traits>
+concept snapshotable = requires {typename snapshot<std::remove_cvref_t<T>, CharT, Traits>::replayed;};
+
+// replay_range (input range of the replayed elements of a snapshotted range):
+
+template <typename Element>
+class replay_range {
+    const std::byte* base;
+    std::size_t pos;
+    std::size_t n;
+public:
+    class iterator {
+        const std::byte* base = nullptr;
+        std::size_t pos = 0;
+        std::size_t remaining = 0;
+    public:
+        using value_type = typename Element::replayed;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const std::byte* base_, std::size_t pos_, std::size_t n) noexcept
+            : base{base_}, pos{pos_}, remaining{n} {}
+
+        value_type operator*() const noexcept {auto p = pos; return Element::read(base, p);}
+        iterator& operator++() noexcept {Element::skip(base, pos); --remaining; return *this;}
+        void operator++(int) noexcept {++*this;}
+        friend bool operator==(const iterator& itr, std::default_sentinel_t) noexcept {return !itr.remaining;}
+    };
+
+    replay_range(const std::byte* base_, std::size_t pos_, std::size_t n_) noexcept
+        : base{base_}, pos{pos_}, n{n_} {}
+
+    iterator begin() const noexcept {return {base, pos, n};}
+    std::default_sentinel_t end() const noexcept {return {};}
+};
+
+template <typename T, typename CharT, typename Traits> requires std::is_arithmetic_v<T>
+struct snapshot<T, CharT, Traits, plan_kind::value> {
+    using replayed = T;
+
+    static std::size_t size(const T&, std::size_t pos) noexcept {return raw_size<T>(pos);}
+    static void write(const T& x, std::byte* base, std::size_t& pos) noexcept {put_raw(base, pos, x);}
+    static replayed read(const std::byte* base, std::size_t& pos) noexcept {return get_raw<T>(base, pos);}
+    static void skip(const std::byte*, std::size_t& pos) noexcept {pos = raw_size<T>(pos);}
+};
+
+template <typename T, typename CharT, typename Traits>
+struct snapshot<T, CharT, Traits, plan_kind::string> { // count, characters
+    using replayed = std::basic_string_view<CharT, Traits>;
+
+    static std::size_t size(const T& x, std::size_t pos) noexcept
+    {return align_up(raw_size<std::size_t>(pos), alignof(CharT)) + replayed(x).size() * sizeof(CharT);}
+
+    static void write(const T& x, std::byte* base, std::size_t& pos) noexcept {
+        auto str = replayed(x);
+        put_raw(base, pos, str.size());
+        pos = align_up(pos, alignof(CharT));
+        std::memcpy(base + pos, str.data(), str.size() * sizeof(CharT));
+        pos += str.size() * sizeof(CharT);
+    }
+
+    static replayed read(const std::byte* base, std::size_t& pos) noexcept {
+        auto n = get_raw<std::size_t>(base, pos);
+        pos = align_up(pos, alignof(CharT));
+        auto str = replayed{reinterpret_cast<const CharT*>(base + pos), n};
+        pos += n * sizeof(CharT);
+        return str;
+    }
+
+    static void skip(const std::byte* base, std::size_t& pos) noexcept {read(base, pos);}
+};
+
+template <typename T, typename CharT, typename Traits>
+    requires snapshotable<typename T::first_type, CharT, Traits> && snapshotable<typename T::second_type, CharT, Traits>
+struct snapshot<T, CharT, Traits, plan_kind::pair> { // first, second
+    using first = snapshot<std::remove_cvref_t<typename T::first_type>, CharT, Traits>;
+    using second = snapshot<std::remove_cvref_t<typename T::second_type>, CharT, Traits>;
+    using replayed = std::pair<typename first::replayed, typename second::replayed>;
+
+    static std::size_t size(const T& x, std::size_t pos) noexcept
+    {return second::size(x.second, first::size(x.first, pos));}
+
+    static void write(const T& x, std::byte* base, std::size_t& pos) noexcept
+    {first::write(x.first, base, pos); second::write(x.second, base, pos);}
+
+    static replayed read(const std::byte* base, std::size_t& pos) noexcept
+    {return replayed{first::read(base, pos), second::read(base, pos)};} // (braced, so read in order)
+
+    static void skip(const std::byte* base, std::size_t& pos) noexcept
+    {first::skip(base, pos); second::skip(base, pos);}
+};
+
+template <typename T, typename CharT, typename Traits, typename = std::make_index_sequence<std::tuple_size_v<fields_t<T>>>>
+struct tuple_snapshot;
+
+template <typename T, typename CharT, typename Traits, std::size_t... Is>
+    requires (snapshotable<std::tuple_element_t<Is, fields_t<T>>, CharT, Traits> && ...)
+struct tuple_snapshot<T, CharT, Traits, std::index_sequence<Is...>> { // elements (or fields)
+    template <std::size_t I>
+    using element = snapshot<std::remove_cvref_t<std::tuple_element_t<I, fields_t<T>>>, CharT, Traits>;
+    using replayed = std::tuple<typename element<Is>::replayed...>;
+
+    static std::size_t size(const T& x, std::size_t pos) noexcept
+    {const auto& fields = as_tuple(x); ((pos = element<Is>::size(std::get<Is>(fields), pos)), ...); return pos;}
+
+    static void write(const T& x, std::byte* base, std::size_t& pos) noexcept
+    {const auto& fields = as_tuple(x); (element<Is>::write(std::get<Is>(fields), base, pos), ...);}
+
+    static replayed read([[maybe_unused]] const std::byte* base, [[maybe_unused]] std::size_t& pos) noexcept
+    {return replayed{element<Is>::read(base, pos)...};}
+
+    static void skip([[maybe_unused]] const std::byte* base, [[maybe_unused]] std::size_t& pos) noexcept
+    {(element<Is>::skip(base, pos), ...);}
+};
+
+template <typename T, typename CharT, typename Traits> requires requires {typename tuple_snapshot<T, CharT, Traits>::replayed;}
+struct snapshot<T, CharT, Traits, plan_kind::tuple>: tuple_snapshot<T, CharT, Traits> {};
+
+template <typename T, typename CharT, typename Traits>
+    requires std::ranges::forward_range<const T> && snapshotable<std::ranges::range_reference_t<const T>, CharT, Traits>
+struct snapshot<T, CharT, Traits, plan_kind::range> {
+    using element_type = std::remove_cvref_t<std::ranges::range_reference_t<const T>>;
+    using element = snapshot<element_type, CharT, Traits>;
+
+    // contiguous ranges of arithmetic values are copied as a block (count,
+    // values) and replayed as a span (so the span output path applies); other
+    // ranges are copied element by element (count, size in bytes, elements)
+    static constexpr bool block = std::ranges::contiguous_range<const T> && std::is_arithmetic_v<element_type>;
+
+    using replayed = std::conditional_t<block, std::span<const element_type>, replay_range<element>>;
+
+    static std::size_t size(const T& x, std::size_t pos) noexcept {
+        if constexpr (block)
+            return align_up(raw_size<std::size_t>(pos), alignof(element_type)) + std::ranges::size(x) * sizeof(element_type);
+        else {
+            pos = raw_size<std::size_t>(raw_size<std::size_t>(pos));
+            for (const auto& e: x)
+                pos = element::size(e, pos);
+            return pos;
+        }
+    }
+
+    static void write(const T& x, std::byte* base, std::size_t& pos) noexcept {
+        if constexpr (block) {
+            auto n = std::size_t(std::ranges::size(x));
+            put_raw(base, pos, n);
+            pos = align_up(pos, alignof(element_type));
+            if (n)
+                std::memcpy(base + pos, std::ranges::data(x), n * sizeof(element_type));
+            pos += n * sizeof(element_type);
+        }
+        else {
+            auto header = pos;
+            pos = raw_size<std::size_t>(raw_size<std::size_t>(pos));
+            auto start = pos;
+            std::size_t n = 0;
+            for (const auto& e: x) {
+                element::write(e, base, pos);
+                ++n;
+            }
+            auto bytes = pos - start;
+            put_raw(base, header, n);
+            put_raw(base, header, bytes);
+        }
+    }
+
+    static replayed read(const std::byte* base, std::size_t& pos) noexcept {
+        auto n = get_raw<std::size_t>(base, pos);
+        if constexpr (block) {
+            pos = align_up(pos, alignof(element_type));
+            auto values = replayed{reinterpret_cast<const element_type*>(base + pos), n};
+            pos += n * sizeof(element_type);
+            return values;
+        }
+        else {
+            auto bytes = get_raw<std::size_t>(base, pos);
+            auto elements = replayed{base, pos, n};
+            pos += bytes;
+            return elements;
+        }
+    }
+
+    static void skip(const std::byte* base, std::size_t& pos) noexcept {read(base, pos);}
+};
+
+// spsc_ring (single-producer, single-consumer ring buffer of variable size
+// records; a record is written in place by the producer and published by
+// advancing the head, and consumed in place and released by advancing the
+// tail; a record that won't fit before the end of the buffer is preceded by
+// padding to the end, marked by a zero size, which is published on its own so
+// that any record of up to the capacity fits once the consumer catches up):
+
+class spsc_ring {
+    std::unique_ptr<std::byte[]> buf;
+    std::size_t mask;
+
+    // producer side:
+    std::size_t head = 0; // (unpublished)
+    std::size_t cached_tail = 0;
+    alignas(64) std::atomic<std::size_t> published{0};
+
+    // consumer side:
+    alignas(64) std::atomic<std::size_t> tail{0};
+
+    // waits until there is space for size bytes at the head
+    void wait_for(std::size_t size) {
+        while (head + size - cached_tail > capacity()) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (head + size - cached_tail > capacity())
+                std::this_thread::yield();
+        }
+    }
+
+public:
+    static constexpr std::size_t record_align = alignof(std::max_align_t);
+
+    explicit spsc_ring(std::size_t capacity) // (capacity must be a power of 2)
+        : buf{new std::byte[capacity]}, mask{capacity - 1} {}
+
+    std::size_t capacity() const noexcept {return mask + 1;}
+
+    // returns storage for a record of size bytes (a multiple of record_align
+    // beginning with its size as a uint32_t, which must not be 0, and at most
+    // capacity()), waiting until there is space; the record is published by
+    // commit()
+    std::byte* reserve(std::size_t size) {
+        auto offset = head & mask;
+        if (offset + size > capacity()) {
+            auto pad = capacity() - offset;
+            wait_for(pad);
+            std::memset(buf.get() + offset, 0, sizeof(std::uint32_t));
+            head += pad;
+            published.store(head, std::memory_order_release);
+        }
+        wait_for(size);
+        return buf.get() + (head & mask);
+    }
+
+    void commit(std::size_t size) noexcept {
+        head += size;
+        published.store(head, std::memory_order_release);
+    }
+
+    // calls consume for each published record, releasing each afterward;
+    // returns whether there were any
+    template <typename Consume>
+    bool drain(Consume&& consume) {
+        auto end = published.load(std::memory_order_acquire);
+        auto pos = tail.load(std::memory_order_relaxed);
+        if (pos == end)
+            return false;
+        while (pos != end) {
+            auto record = buf.get() + (pos & mask);
+            std::uint32_t size;
+            std::memcpy(&size, record, sizeof size);
+            if (size) {
+                consume(static_cast<const std::byte*>(record));
+                pos += size;
+            }
+            else
+                pos = (pos | mask) + 1; // (padding)
+            tail.store(pos, std::memory_order_release);
+        }
+        return true;
+    }
+};
+
+// sink_worker (a sink's background thread, which repeatedly calls drain() to
+// output whatever has been written, returning whether there was any, and
+// flush_stream() to flush the stream when idle or asked to by flush()):
+
+class sink_worker {
+    std::atomic<std::uint64_t> flush_requests{0};
+    std::atomic<std::uint64_t> flushes{0};
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    template <typename Drain, typename FlushStream>
+    void run(Drain& drain, FlushStream& flush_stream) {
+        unsigned idle = 0;
+        bool unflushed = false;
+        for (;;) {
+            // (loaded before draining, so that whatever was written before a
+            // flush request or stop() is drained)
+            auto stop = stopping.load(std::memory_order_acquire);
+            auto requests = flush_requests.load(std::memory_order_acquire);
+
+            bool any = drain();
+
+            if (requests != flushes.load(std::memory_order_relaxed)) {
+                flush_stream();
+                unflushed = false;
+                flushes.store(requests, std::memory_order_release);
+                flushes.notify_all();
+            }
+            else if (any)
+                unflushed = true;
+
+            if (any)
+                idle = 0;
+            else if (stop)
+                break;
+            else {
+                if (unflushed) { // (so output isn't held back while idle)
+                    flush_stream();
+                    unflushed = false;
+                }
+                if (++idle < 64)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds{100});
+            }
+        }
+        flush_stream();
+    }
+
+public:
+    template <typename Drain, typename FlushStream>
+    void start(Drain drain, FlushStream flush_stream)
+    {thread = std::thread{[this, drain, flush_stream]() mutable {run(drain, flush_stream);}};}
+
+    // drains, flushes and joins the thread
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        thread.join();
+    }
+
+    // waits until whatever was written before the call has been output and
+    // the stream flushed
+    void flush() {
+        auto target = flush_requests.fetch_add(1, std::memory_order_acq_rel) + 1;
+        for (auto done = flushes.load(std::memory_order_acquire); done < target; done = flushes.load(std::memory_order_acquire))
+            flushes.wait(done, std::memory_order_acquire);
+    }
+};
+
+} // namespace helpers
+
+// basic_async_sink (see above):
+
+template <typename CharT, typename Traits>
+class basic_async_sink {
+    using delimiters_type = basic_delimiters<CharT, Traits>;
+    using ostream = std::basic_ostream<CharT, Traits>;
+    using string_view = std::basic_string_view<CharT, Traits>;
+
+    struct header { // (of a record; followed by the snapshot)
+        std::uint32_t size;
+        void (*replay)(const std::byte*, const delimiters_type&, ostream&);
+        delimiters_type delims;
+    };
+
+    static constexpr std::size_t record_align = helpers::spsc_ring::record_align;
+    static constexpr std::size_t snapshot_offset = helpers::align_up(sizeof(header), record_align);
+    static constexpr std::size_t min_ring_size = 4096;
+
+    static constexpr auto record_delim_default = helpers::str_literal_cast<CharT>("\n");
+
+    ostream& out;
+    std::size_t ring_size;
+    std::basic_string<CharT, Traits> record_delim;
+    const std::uint64_t id = next_id(); // (unlike the address, never reused)
+
+    std::mutex rings_mutex; // (for rings)
+    std::vector<std::unique_ptr<helpers::spsc_ring>> rings;
+    std::atomic<std::size_t> ring_count{0};
+
+    std::vector<helpers::spsc_ring*> active; // (rings, as last seen by the background thread)
+
+    helpers::sink_worker worker;
+
+    static std::uint64_t next_id() noexcept {
+        static std::atomic<std::uint64_t> ids{0};
+        return ++ids;
+    }
+
+    // returns the calling thread's ring, allocating it on its first write
+    helpers::spsc_ring& ring() {
+        struct entry {std::uint64_t sink_id; helpers::spsc_ring* ring;};
+        static thread_local std::vector<entry> entries; // (this thread's rings, by sink)
+        for (const auto& e: entries)
+            if (e.sink_id == id)
+                return *e.ring;
+        auto lock = std::lock_guard{rings_mutex};
+        auto& ring = *rings.emplace_back(std::make_unique<helpers::spsc_ring>(ring_size));
+        ring_count.store(rings.size(), std::memory_order_release);
+        entries.push_back({id, &ring});
+        return ring;
+    }
+
+    template <typename Object>
+    static void replay(const std::byte* snapshot, const delimiters_type& delims, ostream& out) {
+        std::size_t pos = 0;
+        auto x = helpers::snapshot<Object, CharT, Traits>::read(snapshot, pos);
+        helpers::output(x, delims, delims.top_as_sub, out);
+    }
+
+    void output_record(const std::byte* record) {
+        header h;
+        std::memcpy(&h, record, sizeof h);
+        h.replay(record + snapshot_offset, h.delims, out);
+        helpers::put_literal(out, string_view{record_delim});
+    }
+
+    bool drain() { // (on the background thread)
+        if (ring_count.load(std::memory_order_acquire) != active.size()) {
+            auto lock = std::lock_guard{rings_mutex};
+            active.clear();
+            for (const auto& ring: rings)
+                active.push_back(ring.get());
+        }
+        bool any = false;
+        for (auto ring: active)
+            any |= ring->drain([this](const std::byte* record) {output_record(record);});
+        return any;
+    }
+
+public:
+    // (ring_size is the size in bytes of each thread's ring buffer, rounded up
+    // to a power of 2; record_delim is output after each record)
+    explicit basic_async_sink(ostream& out_, std::size_t ring_size_ = 1 << 16, string_view record_delim_ = record_delim_default.view())
+        : out{out_}, ring_size{std::bit_ceil(std::max(ring_size_, min_ring_size))}, record_delim{record_delim_}
+    {worker.start([this] {return drain();}, [this] {out.flush();});}
+
+    ~basic_async_sink()
+    {worker.stop();}
+
+    template <typename Object> requires helpers::snapshotable<Object, CharT, Traits>
+    void write(const Object& obj, const delimiters_type& delims) {
+        using snapshot = helpers::snapshot<Object, CharT, Traits>;
+        auto size = helpers::align_up(snapshot_offset + snapshot::size(obj, 0), record_align);
+        auto& ring = this->ring();
+        if (size > ring.capacity() || size > UINT32_MAX)
+            throw std::length_error{"delimited_output: object too large for the async sink's ring buffer"};
+        auto record = ring.reserve(size);
+        auto h = header{std::uint32_t(size), &replay<Object>, delims};
+        std::memcpy(record, &h, sizeof h);
+        std::size_t pos = 0;
+        snapshot::write(obj, record + snapshot_offset, pos);
+        ring.commit(size);
+    }
+
+    template <typename Object> requires helpers::snapshotable<Object, CharT, Traits>
+    void write(const Object& obj)
+    {write(obj, delimiters_type{});}
+
+    void flush()
+    {worker.flush();}
+};
+
+// basic_shared_sink (see above):
+
+template <typename CharT, typename Traits>
+class basic_shared_sink {
+    using delimiters_type = basic_delimiters<CharT, Traits>;
+    using ostream = std::basic_ostream<CharT, Traits>;
+    using string_view = std::basic_string_view<CharT, Traits>;
+
+    static constexpr std::size_t min_capacity = 4096;
+    static constexpr auto record_delim_default = helpers::str_literal_cast<CharT>("\n");
+
+    ostream& out;
+    std::size_t mask; // (capacity - 1)
+    std::unique_ptr<CharT[]> buf;
+    std::basic_string<CharT, Traits> record_delim;
+
+    // positions (in characters written since construction; a position's
+    // character is at buf[pos & mask]):
+    alignas(64) std::atomic<std::uint64_t> reserved{0}; // end of the reserved text
+    alignas(64) std::atomic<std::uint64_t> published{0}; // end of the copied text, in reservation order
+    alignas(64) std::atomic<std::uint64_t> drained{0}; // end of the text output to the stream
+
+    helpers::sink_worker worker;
+
+    std::size_t capacity() const noexcept {return mask + 1;}
+
+    // copies text to or from the ring buffer at a position, wrapping around
+    void copy_in(std::uint64_t pos, string_view text) noexcept {
+        auto offset = std::size_t(pos & mask);
+        auto first = std::min(text.size(), capacity() - offset);
+        Traits::copy(buf.get() + offset, text.data(), first);
+        Traits::copy(buf.get(), text.data() + first, text.size() - first);
+    }
+
+    void publish(string_view text) {
+        auto size = text.size();
+        if (size > capacity())
+            throw std::length_error{"delimited_output: record too large for the shared sink's buffer"};
+        auto pos = reserved.fetch_add(size, std::memory_order_relaxed);
+        while (pos + size - drained.load(std::memory_order_acquire) > capacity())
+            std::this_thread::yield();
+        copy_in(pos, text);
+        while (published.load(std::memory_order_acquire) != pos)
+            std::this_thread::yield();
+        published.store(pos + size, std::memory_order_release);
+    }
+
+    bool drain() { // (on the background thread)
+        auto begin = drained.load(std::memory_order_relaxed);
+        auto end = published.load(std::memory_order_acquire);
+        if (begin == end)
+            return false;
+        auto offset = std::size_t(begin & mask);
+        auto size = std::size_t(end - begin);
+        auto first = std::min(size, capacity() - offset);
+        if (out.rdbuf()->sputn(buf.get() + offset, first) != std::streamsize(first)
+            || out.rdbuf()->sputn(buf.get(), size - first) != std::streamsize(size - first))
+            out.setstate(std::ios_base::badbit);
+        drained.store(end, std::memory_order_release);
+        return true;
+    }
+
+public:
+    // (capacity is the size in characters of the shared ring buffer, rounded up
+    // to a power of 2; record_delim is output after each record)
+    explicit basic_shared_sink(ostream& out_, std::size_t capacity = 1 << 20, string_view record_delim_ = record_delim_default.view())
+        : out{out_}, mask{std::bit_ceil(std::max(capacity, min_capacity)) - 1}, buf{new CharT[mask + 1]}, record_delim{record_delim_}
+    {worker.start([this] {return drain();}, [this] {out.flush();});}
+
+    ~basic_shared_sink()
+    {worker.stop();}
+
+    template <typename Object>
+    void write(const Object& obj, const delimiters_type& delims) {
+        auto& scratch = helpers::scratch<CharT, Traits>();
+        scratch.start();
+        helpers::output(obj, delims, delims.top_as_sub, scratch.out);
+        helpers::put_literal(scratch.out, string_view{record_delim});
+        publish(scratch.buf.view());
+    }
+
+    template <typename Object>
+    void write(const Object& obj)
+    {write(obj, delimiters_type{});}
+
+    void flush()
+    {worker.flush();}
+};
+
+} // namespace delimited_output
+
+#endif // DELIMITED_ASYNC_HPP
@@ -0,0 +1,62 @@
+// out-of-line definitions for the DELIMITED_OUTPUT_TYPE_ERASED build mode (see
+// "type-erased output primitives" in delimited_output.hpp). compile and link
+// this in when building with DELIMITED_OUTPUT_TYPE_ERASED defined.
+
+#ifndef DELIMITED_OUTPUT_TYPE_ERASED
+#define DELIMITED_OUTPUT_TYPE_ERASED
+#endif
+
+#include "delimited_output.hpp"
+
+namespace delimited_output::helpers {
+
+namespace erased {
+
+#define DELIMITED_OUTPUT_DEFINE_ERASED_LEAF(T) \
+    void put_leaf(std::ostream& out, T x) {out << x;} \
+    void put_leaf(std::wostream& out, T x) {out << x;}
+DELIMITED_OUTPUT_ERASED_LEAF_TYPES(DELIMITED_OUTPUT_DEFINE_ERASED_LEAF)
+#undef DELIMITED_OUTPUT_DEFINE_ERASED_LEAF
+
+void put_leaf(std::wostream& out, wchar_t x) {out << x;}
+void put_leaf(std::ostream& out, std::string_view str) {out << str;}
+void put_leaf(std::wostream& out, std::wstring_view str) {out << str;}
+
+template <typename CharT>
+static void traverse_impl(const range<CharT>& range, const basic_delimiters<CharT>& delims, bool as_sub, std::basic_ostream<CharT>& out) {
+    if (as_sub)
+        out << delims.sub_prefix;
+    if (range.done(range.state))
+        out << delims.empty;
+    else {
+        range.output_next(range.state, out);
+        auto delim = as_sub ? delims.sub_delim : delims.top_delim;
+        while (!range.done(range.state) && out) {
+            out << delim;
+            range.output_next(range.state, out);
+        }
+    }
+    if (as_sub)
+        out << delims.sub_suffix;
+}
+
+void traverse(const range<char>& range, const basic_delimiters<char>& delims, bool as_sub, std::ostream& out)
+{traverse_impl(range, delims, as_sub, out);}
+
+void traverse(const range<wchar_t>& range, const basic_delimiters<wchar_t>& delims, bool as_sub, std::wostream& out)
+{traverse_impl(range, delims, as_sub, out);}
+
+} // namespace erased
+
+void put_literal(std::ostream& out, std::string_view str) {out << str;}
+void put_literal(std::wostream& out, std::wstring_view str) {out << str;}
+
+template struct scratch_stream<char, std::char_traits<char>>;
+template struct scratch_stream<wchar_t, std::char_traits<wchar_t>>;
+template scratch_stream<char, std::char_traits<char>>& scratch();
+template scratch_stream<wchar_t, std::char_traits<wchar_t>>& scratch();
+
+template class table_layout<char, std::char_traits<char>>;
+template class table_layout<wchar_t, std::char_traits<wchar_t>>;
+
+} // namespace delimited_output::helpers
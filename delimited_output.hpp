@@ -4,7 +4,33 @@
 #include <ostream>
 #include <tuple>
 #include <type_traits>
+#include <algorithm>
+#include <ranges>
+#include <utility>
+#include <optional>
+#include <variant>
+#if __has_include(<expected>)
+#include <expected>
+#endif
+#include <memory>
+#include <deque>
+#include <array>
+#include <span>
+#include <limits>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <locale>
+#include <iterator>
+#include <string>
 #include <cassert>
+#if __has_include(<unistd.h>)
+#include <cerrno>
+#include <unistd.h>
+#define DELIMITED_OUTPUT_HAS_WRITE_FD
+#endif
 #include "str_literal.hpp"
 
 namespace delimited_output {
@@ -38,6 +64,23 @@ namespace delimited_output {
 // outputs:
 //    1, Two, 3
 
+// delimited() outputs an optional, a variant or an expected (if the standard
+// library has it) as the object it holds (the value, the active alternative,
+// or the value or error), or as the none text (by default, "<none>") if it
+// holds nothing (a disengaged optional, a variant holding a monostate or
+// valueless, or an expected with a void value); for example:
+//    cout << delimited(std::vector<std::optional<int>>{1, std::nullopt, 3})
+// outputs:
+//    1, <none>, 3
+
+// delimited() outputs an aggregate struct without a stream insertion operator
+// as a tuple of its fields (of up to 16), and a user type that's tuple-like
+// (with std::tuple_size and get) as a tuple of its elements; for example:
+//    struct point {int x, y;};
+//    cout << delimited(std::vector<point>{{1, 2}, {3, 4}})
+// outputs:
+//    (1, 2), (3, 4)
+
 // By default, delimited() will output any other type of object for which a
 // stream insertion operator (operator<<) is defined, in which case it will be
 // output via that operator.
@@ -68,6 +111,39 @@ namespace delimited_output {
 // as
 //    std::cout << delimited(std::string("Hello"))
 // is OK as the helper object will be valid for the duration of the expression.
+// Views (and other ranges that can only be iterated as non-const, such as
+// filter_view and istream_view) given as rvalues are moved into the helper
+// object instead, so, for example:
+//    cout << delimited(arr | std::views::filter(is_odd))
+// works, and an lvalue such view is iterated via a non-const reference.
+
+// delimited() with atomic() set (see atomic in delimiters below) formats the
+// object in full before writing it to the stream buffer in one go, e.g., so that
+// lines output to cout by concurrent threads aren't torn (the terminator, here
+// a newline, is written in the same go; a '\n' inserted after it would be a
+// separate write):
+//    cout << delimited(a_map).atomic().terminator("\n");
+
+// delimited() with table() set outputs a range of pairs, tuples or ranges as a
+// table with its columns aligned (see table in delimiters below):
+//    cout << delimited(a_map).table() << '\n';
+
+// views::delimited():
+
+// views::delimited() presents the delimited output of an object as a lazy
+// input range of characters, generated on demand as the range is iterated
+// instead of being formatted into a string up front; for example:
+//    auto text = views::delimited(arr);
+//    std::ranges::copy(text, std::ostreambuf_iterator<char>(socket_stream));
+// For a range object, only the output of one element is held in memory at a
+// time (except for a table, whose columns can only be aligned once all of its
+// rows have been formatted, and a sorted unordered container, which is output
+// in one go once its elements have been sorted). The view's chunks() member function presents the
+// same output as a range of string views (each valid until the next one is
+// generated) for consumers that can take it a block at a time. Output is
+// generated by a stream with default formatting (and the global locale). The
+// view stores a reference to the object (or, as for delimited(), the object
+// itself for an rvalue view), so the object must outlive it.
 
 template <typename, typename> struct basic_delimiters;
 
@@ -78,16 +154,17 @@ concept iterator = std::input_or_output_iterator<T>;
 
 template <typename, typename CharT, typename Traits = std::char_traits<CharT>> class inserter;
 template <iterator, typename CharT, typename Traits = std::char_traits<CharT>> class sequence_inserter;
+template <typename, typename CharT, typename Traits = std::char_traits<CharT>> class delimited_view;
 
 }
 
 template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Object>
-inline auto delimited(const Object& obj)
-{return helpers::inserter<Object, CharT, Traits>{obj};}
+inline auto delimited(Object&& obj)
+{return helpers::inserter<Object, CharT, Traits>{std::forward<Object>(obj)};}
 
 template <typename Object>
-inline auto wdelimited(const Object& obj)
-{return delimited<wchar_t>(obj);}
+inline auto wdelimited(Object&& obj)
+{return delimited<wchar_t>(std::forward<Object>(obj));}
 
 template <typename CharT = char, typename Traits = std::char_traits<CharT>, helpers::iterator Iterator>
 inline auto delimited(Iterator begin, Iterator end)
@@ -98,13 +175,29 @@ inline auto wdelimited(Iterator begin, Iterator end)
 {return delimited<wchar_t>(begin, end);}
 
 template <typename CharT, typename Traits, typename Object>
-inline auto delimited(const Object& obj, const basic_delimiters<CharT, Traits>& delims)
-{return helpers::inserter<Object, CharT, Traits>{obj, delims};}
+inline auto delimited(Object&& obj, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::inserter<Object, CharT, Traits>{std::forward<Object>(obj), delims};}
 
 template <typename CharT, typename Traits, helpers::iterator Iterator>
 inline auto delimited(Iterator begin, Iterator end, const basic_delimiters<CharT, Traits>& delims)
 {return helpers::sequence_inserter<Iterator, CharT, Traits>{begin, end, delims};}
 
+namespace views {
+
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Object>
+inline auto delimited(Object&& obj)
+{return helpers::delimited_view<Object, CharT, Traits>{std::forward<Object>(obj)};}
+
+template <typename Object>
+inline auto wdelimited(Object&& obj)
+{return delimited<wchar_t>(std::forward<Object>(obj));}
+
+template <typename CharT, typename Traits, typename Object>
+inline auto delimited(Object&& obj, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::delimited_view<Object, CharT, Traits>{std::forward<Object>(obj), delims};}
+
+} // namespace views
+
 // basic_delimiters, delimiters, wdelimiters:
 
 template <typename CharT, typename Traits = std::char_traits<CharT>>
@@ -120,6 +213,9 @@ struct basic_delimiters { // delimiters and related values
     static constexpr auto pair_delim_default = helpers::str_literal_cast<CharT>(": ");
     static constexpr auto pair_suffix_default = helpers::str_literal_cast<CharT>("]");
     static constexpr auto empty_default = helpers::str_literal_cast<CharT>("<empty>");
+    static constexpr auto none_default = helpers::str_literal_cast<CharT>("<none>");
+    static constexpr auto table_column_delim_default = helpers::str_literal_cast<CharT>("  ");
+    static constexpr auto table_row_delim_default = helpers::str_literal_cast<CharT>("\n");
 
     using string_view = std::basic_string_view<CharT, Traits>;
 
@@ -151,6 +247,59 @@ struct basic_delimiters { // delimiters and related values
 
     string_view empty = empty_default.view(); // text for empty object or empty sequence
 
+    string_view none = none_default.view(); // text for an optional or variant that holds nothing
+
+    std::size_t prefetch = 0; // prefetch distance for node-based ranges
+    // when nonzero, containers that are forward but not random access (map,
+    // set, list, unordered_map, etc.; not views) are traversed with a second
+    // iterator running this many elements ahead, prefetching the elements it
+    // passes, so that the cache misses of walking the nodes overlap with
+    // outputting the elements; this helps for large ranges whose nodes aren't
+    // in cache
+
+    bool atomic = false; // output the object to the stream buffer in one write
+    // when true, the object is formatted in full into a thread-local buffer
+    // (with the stream's formatting state and locale) and then written to the
+    // stream's buffer with a single sputn, so that, e.g., if the stream buffer
+    // makes each write atomic (as cout's does when synchronized with stdio),
+    // lines output by concurrent threads aren't torn, and an unbuffered stream
+    // gets one write per object instead of one per token
+
+    string_view terminator = {}; // text output after the object (e.g., "\n")
+    // output by stream insertion of delimited() and cached_delimited() (not
+    // by views::delimited, format_to_n, etc.) right after the top-level object;
+    // when atomic is true, and always for cached_delimited(), which writes its
+    // output in one go, it's part of the same single write, so a line and its
+    // newline can't be separated; an appender ignores it (its outputs together
+    // being the output of the whole range), as does a formatter
+
+    bool table = false; // output a range of collections as a table
+    string_view column_delim = table_column_delim_default.view(); // table column delimiter
+    // when table is true (for a range whose elements are pairs, tuples or
+    // ranges), each element is a row, separated by top_delim, and its elements
+    // are the cells, separated by column_delim and output as sub-level
+    // elements; each cell is padded with the stream's fill character to the
+    // width (in characters) of the widest cell in its column, on the left if
+    // the stream's adjustfield is right and otherwise on the right (except for
+    // the last cell in a row); the inserter's table() setter also sets
+    // top_delim to table_row_delim_default
+    // example for map<string, int>, with table():
+    //    Alice  30
+    //    Bob    4
+    //    Carol  120
+
+    bool sorted = false; // output an unordered associative container in key order
+    std::size_t sorted_limit = std::size_t(-1); // (when sorted) the number of elements output
+    // when true, the top-level unordered_map, unordered_set, etc. is output in
+    // ascending key order (by <) instead of hash order, so that its output is
+    // the same from run to run; pointers to the elements are sorted, not the
+    // elements, which aren't copied; only the first sorted_limit elements in
+    // order are output (then only those are fully sorted); a container whose
+    // keys have no < is output in hash order
+    // note: only the top level is sorted; unordered containers nested in the
+    // object (e.g., the values of a map<int, unordered_set<int>>, or the
+    // elements of a vector of unordered_sets) are still output in hash order
+
     // note: delimiter stores string views, which are essentially references,
     // and thus are only as valid as such
 };
@@ -158,6 +307,344 @@ struct basic_delimiters { // delimiters and related values
 using delimiters = basic_delimiters<char>;
 using wdelimiters = basic_delimiters<wchar_t>;
 
+// cached_delimited(), basic_delimited_cache, delimited_cache,
+// wdelimited_cache:
+
+// cached_delimited() outputs an object as delimited() does, but keeps the
+// output in a cache object supplied by the caller, keyed on the object's address
+// and type, and outputs it from there (with a single write to the stream
+// buffer) for so long as the version number supplied by the caller, the
+// delimiters and the stream's formatting state (flags, precision, fill and
+// width, but not locale) are unchanged; for example:
+//    auto cache = delimited_cache{};
+//    cout << cached_delimited(cache, config, config_version) << '\n';
+// The caller must change the version whenever the object changes. A cache
+// keeps one output per object (replaced when it's out of date), until the
+// cache is cleared or destroyed; it isn't thread-safe.
+
+template <typename CharT, typename Traits = std::char_traits<CharT>> class basic_delimited_cache;
+
+using delimited_cache = basic_delimited_cache<char>;
+using wdelimited_cache = basic_delimited_cache<wchar_t>;
+
+namespace helpers {
+
+template <typename Object, typename CharT, typename Traits>
+class cached_inserter {
+    basic_delimited_cache<CharT, Traits>& cache;
+    const Object& obj;
+    std::uint64_t version;
+    basic_delimiters<CharT, Traits> delims;
+public:
+    cached_inserter(basic_delimited_cache<CharT, Traits>& cache_, const Object& obj_, std::uint64_t version_, const basic_delimiters<CharT, Traits>& delims_) noexcept
+        : cache{cache_}, obj{obj_}, version{version_}, delims{delims_} {}
+
+    friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& out, const cached_inserter& ci)
+    {ci.cache.output(out, ci.obj, ci.version, ci.delims); return out;}
+};
+
+}
+
+template <typename CharT, typename Traits, typename Object>
+inline auto cached_delimited(basic_delimited_cache<CharT, Traits>& cache, const Object& obj, std::uint64_t version, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::cached_inserter<Object, CharT, Traits>{cache, obj, version, delims};}
+
+template <typename CharT, typename Traits, typename Object>
+inline auto cached_delimited(basic_delimited_cache<CharT, Traits>& cache, const Object& obj, std::uint64_t version)
+{return helpers::cached_inserter<Object, CharT, Traits>{cache, obj, version, basic_delimiters<CharT, Traits>{}};}
+
+// basic_delimited_appender, delimited_appender, wdelimited_appender:
+
+// An appender outputs a range that is only ever appended to (e.g., a vector of
+// events) a bit at a time: each time, only the elements added since the last
+// time are output, continuing the delimiter sequence, so that the output of
+// all the calls together is the same as that of delimited() for the range (if
+// it isn't empty; nothing is output for an empty range, and top_as_sub is
+// ignored); for example:
+//    auto appender = delimited_appender{};
+//    cout << appender(events);   // e.g.: 1, 2
+//    ...                         // (3 and 4 appended to events)
+//    cout << appender(events);   // e.g.: , 3, 4
+// Getting to the new elements is constant-time for random access ranges and
+// linear for other ranges. reset() starts over, e.g., for a range that has
+// been cleared. An appender keeps its own copy of the delimiters' strings.
+
+template <typename CharT, typename Traits = std::char_traits<CharT>> class basic_delimited_appender;
+
+using delimited_appender = basic_delimited_appender<char>;
+using wdelimited_appender = basic_delimited_appender<wchar_t>;
+
+// basic_delimited_formatter, delimited_formatter, wdelimited_formatter:
+
+// A formatter formats objects of one type over and over (e.g., once per
+// iteration of a loop) into a buffer that it keeps: format() returns a view of
+// the output (valid until the next call), and the buffer's capacity is reused,
+// so once it's large enough a call doesn't allocate; for example:
+//    auto formatter = delimited_formatter<vector<int>>{};
+//    for (...)
+//        log(formatter.format(levels));   // e.g.: 1, 2, 3
+// A formatter keeps its own copy of the delimiters' strings and its own stream,
+// which formats as a stream does by default; stream() gives access to it for
+// other formatting (e.g., a precision or a locale), which then applies to all
+// later calls.
+
+template <typename T, typename CharT, typename Traits = std::char_traits<CharT>> class basic_delimited_formatter;
+
+template <typename T> using delimited_formatter = basic_delimited_formatter<T, char>;
+template <typename T> using wdelimited_formatter = basic_delimited_formatter<T, wchar_t>;
+
+// delimited_diff(), wdelimited_diff():
+
+// delimited_diff() outputs only the differences between two objects of the
+// same range, pair or tuple type: each difference is output as a
+// sub-collection of where it is (the index, or the key for a sorted
+// associative container such as a map or a set), the element in the first
+// object and the element in the second (with the empty marker for an element
+// that one of them doesn't have); if there are no differences, the empty
+// marker is output; e.g., for the vectors {1, 2, 3} and {1, 5}:
+//    (1, 2, 5), (2, 3, <empty>)
+// and for the maps {{1, "a"}, {2, "b"}} and {{2, "c"}, {3, "d"}}:
+//    (1, a, <empty>), (2, b, c), (3, <empty>, d)
+// Elements (for maps, mapped values) are compared with ==. Sorted associative
+// containers are compared in one merge-like pass over both, unordered ones
+// (such as an unordered_map) by looking up each key of one in the other (the
+// differences are then output in the first's and then the second's iteration
+// order; unordered multisets and multimaps aren't supported), and other ranges
+// by position; for contiguous ranges of elements that can be compared as
+// bytes, identical stretches are skipped with memcmp().
+
+namespace helpers {
+
+template <typename Object, typename CharT, typename Traits>
+void output_diff(std::basic_ostream<CharT, Traits>& out, const Object& a, const Object& b, const basic_delimiters<CharT, Traits>& delims);
+
+template <typename Object, typename CharT, typename Traits>
+class diff_inserter {
+    const Object& a;
+    const Object& b;
+    basic_delimiters<CharT, Traits> delims;
+public:
+    diff_inserter(const Object& a_, const Object& b_, const basic_delimiters<CharT, Traits>& delims_) noexcept
+        : a{a_}, b{b_}, delims{delims_} {}
+
+    friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& out, const diff_inserter& di)
+    {output_diff(out, di.a, di.b, di.delims); return out;}
+};
+
+}
+
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Object>
+inline auto delimited_diff(const Object& a, const Object& b)
+{return helpers::diff_inserter<Object, CharT, Traits>{a, b, basic_delimiters<CharT, Traits>{}};}
+
+template <typename Object>
+inline auto wdelimited_diff(const Object& a, const Object& b)
+{return delimited_diff<wchar_t>(a, b);}
+
+template <typename CharT, typename Traits, typename Object>
+inline auto delimited_diff(const Object& a, const Object& b, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::diff_inserter<Object, CharT, Traits>{a, b, delims};}
+
+// delimited_format_to_n(), delimited_formatted_size():
+
+// delimited_format_to_n() outputs an object as delimited() would (with default
+// formatting) into a character buffer of n characters, without allocating
+// (except with the delimiters' table or sorted set: a table's cells are
+// formatted into an allocated arena to be measured, and a sorted container's
+// element pointers are sorted in an allocated vector; use
+// realtime::delimited_format_to_n(), which ignores those, where allocating
+// isn't allowed); if the output doesn't fit, as much of it as fits is written
+// and the rest of the object isn't traversed (output stops at the next
+// element, except in a table, whose cells are all formatted first); returns
+// where the output ended, its size and whether it was truncated; for example:
+//    char payload[512];
+//    auto result = delimited_format_to_n(payload, sizeof payload, readings);
+//    send(payload, result.size);
+// (nothing is written after the output; in particular, no null terminator).
+// delimited_formatted_size() returns the size of the whole output (as
+// delimited_format_to_n() would need it), without storing it (and, as above,
+// without allocating unless table or sorted is set).
+
+template <typename CharT>
+struct delimited_format_to_n_result {
+    CharT* out; // (past the last character written)
+    std::size_t size; // (of the output written)
+    bool truncated; // (whether the output was cut off)
+};
+
+namespace helpers {
+
+template <typename CharT, typename Traits, typename Object>
+delimited_format_to_n_result<CharT> format_to_n(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims);
+
+template <typename CharT, typename Traits, typename Object>
+std::size_t formatted_size(const Object& obj, const basic_delimiters<CharT, Traits>& delims);
+
+}
+
+template <typename CharT, typename Traits, typename Object>
+inline auto delimited_format_to_n(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::format_to_n(buf, n, obj, delims);}
+
+template <typename CharT, typename Object>
+inline auto delimited_format_to_n(CharT* buf, std::size_t n, const Object& obj)
+{return helpers::format_to_n(buf, n, obj, basic_delimiters<CharT>{});}
+
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename Object>
+inline std::size_t delimited_formatted_size(const Object& obj)
+{return helpers::formatted_size(obj, basic_delimiters<CharT, Traits>{});}
+
+template <typename CharT, typename Traits, typename Object>
+inline std::size_t delimited_formatted_size(const Object& obj, const basic_delimiters<CharT, Traits>& delims)
+{return helpers::formatted_size(obj, delims);}
+
+// realtime::delimited_format_to_n():
+
+// realtime::delimited_format_to_n() is delimited_format_to_n() for code with
+// hard deadlines (e.g., audio or control threads): it's noexcept, writes only
+// to the given buffer (it doesn't allocate, and doesn't use a stream or a
+// locale) and stops traversing the object once the buffer is full. It outputs
+// what's made of numbers (formatted by std::to_chars as a stream with default
+// formatting and the classic locale would: floating-point numbers with a
+// precision of 6), bools (as 1 or 0), characters of the buffer's type and
+// strings; other types don't compile. The delimiters' table, sorted, prefetch
+// and atomic settings are ignored. It works with exceptions disabled
+// (-fno-exceptions). For example:
+//    char line[256];
+//    auto result = realtime::delimited_format_to_n(line, sizeof line, levels);
+
+namespace helpers {
+
+template <typename CharT, typename Traits, typename Object>
+delimited_format_to_n_result<CharT> format_to_n_realtime(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims) noexcept;
+
+}
+
+namespace realtime {
+
+template <typename CharT, typename Traits, typename Object>
+inline auto delimited_format_to_n(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims) noexcept
+{return helpers::format_to_n_realtime(buf, n, obj, delims);}
+
+template <typename CharT, typename Object>
+inline auto delimited_format_to_n(CharT* buf, std::size_t n, const Object& obj) noexcept
+{return helpers::format_to_n_realtime(buf, n, obj, basic_delimiters<CharT>{});}
+
+} // namespace realtime
+
+// delimited_static():
+
+// delimited_static() formats an object at compile-time, as
+// realtime::delimited_format_to_n() would but with integers only (no
+// floating-point numbers), into a helpers::str_literal (of the exact size,
+// which has data(), size(), view(), etc.); the object is given as a template
+// argument (of a structural type, such as std::array<int, N>) or is returned
+// by a lambda (for other types, e.g., of strings), as are delimiters other
+// than the defaults; for example:
+//    constexpr auto text = delimited_static<std::array{1, 2, 3}>(); // 1, 2, 3
+//    constexpr auto table = delimited_static([] {return std::array{std::pair{1, "One"}};}); // [1: One]
+//    cout << text.view() << '\n';
+
+namespace helpers {
+
+template <typename MakeObject, typename MakeDelims>
+consteval auto make_static();
+
+template <typename CharT, typename Traits>
+struct default_delimiters {
+    constexpr basic_delimiters<CharT, Traits> operator()() const noexcept {return {};}
+};
+
+}
+
+template <typename CharT = char, typename Traits = std::char_traits<CharT>, typename MakeObject>
+consteval auto delimited_static(MakeObject)
+{return helpers::make_static<MakeObject, helpers::default_delimiters<CharT, Traits>>();}
+
+template <typename MakeObject, typename MakeDelims>
+consteval auto delimited_static(MakeObject, MakeDelims)
+{return helpers::make_static<MakeObject, MakeDelims>();}
+
+template <auto Object, typename CharT = char>
+consteval auto delimited_static()
+{return delimited_static<CharT>([] {return Object;});}
+
+#ifdef DELIMITED_OUTPUT_HAS_WRITE_FD
+
+// delimited_write():
+
+// delimited_write() outputs an object as delimited() would (with default
+// formatting), followed by a terminator (by default, a newline), to a file
+// descriptor; the text is formatted in full first and then written with a
+// single write() call (repeated only for whatever part of it a pipe or socket
+// doesn't accept at once), so a record costs one system call and records
+// written concurrently to a pipe aren't torn (if no longer than PIPE_BUF);
+// returns whether all of the text was written (if not, errno says why); e.g.:
+//    delimited_write(STDOUT_FILENO, a_map);
+
+namespace helpers {
+
+template <typename Object>
+bool write_fd(int fd, const Object& obj, const delimiters& delims, std::string_view terminator);
+
+}
+
+template <typename Object>
+inline bool delimited_write(int fd, const Object& obj, const delimiters& delims = {}, std::string_view terminator = "\n")
+{return helpers::write_fd(fd, obj, delims, terminator);}
+
+#endif // DELIMITED_OUTPUT_HAS_WRITE_FD
+
+// delimited_if_changed(), delimited_last_output:
+
+// delimited_if_changed() outputs an object as delimited() would, but only if
+// its output would differ from the last output recorded in a
+// delimited_last_output object supplied by the caller, e.g., to keep a status
+// logger from repeating an unchanged state; it returns whether it output the
+// object. Whether the output changed is decided from a 64-bit hash: of the
+// elements' bytes for a contiguous range of elements that are compared by
+// their bytes (e.g., a vector<int>), and otherwise of the text (hashed as it's
+// formatted with the stream's formatting state, and formatted again to be
+// output if it's changed); so for such a range a change of the delimiters or
+// the stream's formatting alone isn't output, and a change is missed only if
+// the hashes collide. For example:
+//    auto last_levels = delimited_last_output{};
+//    ...
+//    if (delimited_if_changed(last_levels, clog, levels))
+//        clog << '\n';
+// A delimited_last_output keeps just the last hash, so the caller can keep
+// one per call site, stream or object, as suits; reset() makes the next
+// output unconditional. It isn't thread-safe.
+
+class delimited_last_output {
+    std::uint64_t last_hash = 0;
+    bool has_hash = false;
+
+public:
+    // (records hash as the last output's; returns whether it differs from the
+    // one before)
+    bool update(std::uint64_t hash) noexcept {
+        if (has_hash && last_hash == hash)
+            return false;
+        last_hash = hash;
+        has_hash = true;
+        return true;
+    }
+
+    void reset() noexcept {has_hash = false;}
+};
+
+namespace helpers {
+
+template <typename CharT, typename Traits, typename Object>
+bool output_if_changed(delimited_last_output& last, std::basic_ostream<CharT, Traits>& out, const Object& obj, const basic_delimiters<CharT, Traits>& delims);
+
+}
+
+template <typename CharT, typename Traits, typename Object>
+inline bool delimited_if_changed(delimited_last_output& last, std::basic_ostream<CharT, Traits>& out, const Object& obj, const basic_delimiters<CharT, Traits>& delims = {})
+{return helpers::output_if_changed(last, out, obj, delims);}
+
 namespace helpers {
 
 // ostream_insertable:
@@ -167,182 +654,2087 @@ concept ostream_insertable = requires(std::basic_ostream<CharT, Traits>& out, co
     {out << x} -> std::same_as<std::basic_ostream<CharT, Traits>&>;
 };
 
-// output (these forward declarations are necessary):
+// format plan:
 
-template <typename CharT, typename Traits, ostream_insertable<CharT, Traits> T>
-inline void output(const T& x, const basic_delimiters<CharT, Traits>&, bool, std::basic_ostream<CharT, Traits>& out);
+// How an object is output is decided at compile-time from its type by a format
+// plan: plan<T, CharT, Traits>::kind says whether a T is output as a value (via
+// its stream insertion operator), as a string, or as a pair, tuple or range
+// collection. Whether a collection is output as a top- or sub-level one is
+// also resolved at compile-time (only the outermost collection can be a top-
+// level one), so outputting, e.g., a vector<map<int, vector<string>>> runs as
+// a fixed set of nested loops with the delimiter choices already made for each
+// level, instead of re-dispatching and re-testing as_sub for every element.
+
+enum class plan_kind {value, string, pair, tuple, range, optional, variant};
+
+template <typename T, typename CharT, typename Traits>
+struct is_string: std::false_type {};
+
+template <typename CharT, typename Traits>
+struct is_string<const CharT*, CharT, Traits>: std::true_type {};
 
 template <typename CharT, typename Traits>
-inline void output(const CharT* str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out);
+struct is_string<CharT*, CharT, Traits>: std::true_type {};
 
 template <typename CharT, typename Traits, typename Allocator>
-inline void output(const std::basic_string<CharT, Traits, Allocator>& str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out);
+struct is_string<std::basic_string<CharT, Traits, Allocator>, CharT, Traits>: std::true_type {};
 
 template <typename CharT, typename Traits>
-inline void output(const std::basic_string_view<CharT, Traits>& str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out);
+struct is_string<std::basic_string_view<CharT, Traits>, CharT, Traits>: std::true_type {};
 
-template <typename T1, typename T2, typename CharT, typename Traits>
-void output(const std::pair<T1, T2>& pair, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out);
+template <typename T>
+struct is_pair: std::false_type {};
 
-template<typename... Ts, typename CharT, typename Traits>
-void output(const std::tuple<Ts...>& tuple, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out);
+template <typename T1, typename T2>
+struct is_pair<std::pair<T1, T2>>: std::true_type {};
 
-template <std::ranges::range T, typename CharT, typename Traits>
-void output(const T& range, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out);
+template <typename T>
+struct is_tuple: std::false_type {};
 
-// inserter:
+template <typename... Ts>
+struct is_tuple<std::tuple<Ts...>>: std::true_type {};
 
-template <typename Object, typename CharT, typename Traits>
-class inserter {
-    const Object& obj;
-    basic_delimiters<CharT, Traits> delims;
-public:
-    inserter(const Object& obj_) noexcept
-        : obj{obj_} {}
-    inserter(const Object& obj_, const basic_delimiters<CharT, Traits>& delims_) noexcept
-        : obj{obj_}, delims{delims_} {}
+// (an optional-like type is output as its value or as none)
+template <typename T>
+struct is_optional: std::false_type {};
 
-    // stream inserter:
+template <typename T>
+struct is_optional<std::optional<T>>: std::true_type {};
 
-    friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& out, const inserter<Object, CharT, Traits>& di)
-    {output(di.obj, di.delims, di.delims.top_as_sub, out); return out;}
+// (a variant-like type is output as its active alternative; for an expected,
+// the alternatives are the value and the error)
+template <typename T>
+struct is_variant: std::false_type {};
 
-    // value setters:
-    // Each function return a reference to *this so calls can be chained; e.g.,
-    // cout << delimited(container).delimiter(" - ").empty("Empty")
+template <typename... Ts>
+struct is_variant<std::variant<Ts...>>: std::true_type {};
 
-    using string_view = std::basic_string_view<CharT, Traits>;
+#ifdef __cpp_lib_expected
+template <typename T, typename E>
+struct is_variant<std::expected<T, E>>: std::true_type {};
+#endif
 
-    auto& delimiter(string_view str) noexcept // sets top_delim and sub_delim (but not pair_delim)
-    {delims.top_delim = str; delims.sub_delim = str; return *this;}
+template <typename T>
+struct alternatives;
 
-    auto& top_delim(string_view str) noexcept
-    {delims.top_delim = str; return *this;}
+template <typename... Ts>
+struct alternatives<std::variant<Ts...>> {
+    using types = std::tuple<Ts...>;
+    template <std::size_t I, typename V> static const auto* get(const V& x) noexcept {return std::get_if<I>(&x);}
+    template <typename V> static std::size_t index(const V& x) noexcept {return x.index();} // (variant_npos if valueless)
+};
 
-    auto& sub_prefix(string_view str) noexcept
-    {delims.sub_prefix = str; return *this;}
+#ifdef __cpp_lib_expected
+template <typename T, typename E>
+struct alternatives<std::expected<T, E>> {
+    using types = std::conditional_t<std::is_void_v<T>, std::tuple<E>, std::tuple<T, E>>;
+    static constexpr std::size_t error = std::tuple_size_v<types> - 1;
+    template <std::size_t I, typename V> static const auto* get(const V& x) noexcept {
+        if constexpr (I == error)
+            return &x.error();
+        else
+            return &*x;
+    }
+    template <typename V> static std::size_t index(const V& x) noexcept
+    {return !x.has_value() ? error : std::is_void_v<T> ? std::variant_npos : 0;}
+};
+#endif
 
-    auto& sub_delim(string_view str) noexcept
-    {delims.sub_delim = str; return *this;}
+// struct output (a tuple-like type, i.e., one with tuple_size and get, such as
+// a user's, or an aggregate struct, is output as a tuple of its elements or
+// fields, unless it has a stream insertion operator; as_tuple() presents one
+// as a std::tuple, of references where get() returns them):
 
-    auto& sub_suffix(string_view str) noexcept
-    {delims.sub_suffix = str; return *this;}
+template <typename T>
+concept tuple_like = requires {std::tuple_size<T>::value;};
 
-    auto& pair_prefix(string_view str) noexcept
-    {delims.pair_prefix = str; return *this;}
+// (converts to any type, to count the fields of an aggregate by how many of
+// them can initialize it; aggregates with C array fields are miscounted, as
+// brace elision lets each array element count as a field)
+struct any_field {
+    template <typename T> operator T() const;
+};
 
-    auto& pair_delim(string_view str) noexcept
-    {delims.pair_delim = str; return *this;}
+template <typename T, std::size_t... Is>
+constexpr bool initializable_with(std::index_sequence<Is...>) noexcept
+{return requires {T{(void(Is), any_field{})...};};}
 
-    auto& pair_suffix(string_view str) noexcept
-    {delims.pair_suffix = str; return *this;}
+template <typename T, std::size_t N = 0>
+constexpr std::size_t field_count() noexcept {
+    if constexpr (N <= 16 && initializable_with<T>(std::make_index_sequence<N + 1>{}))
+        return field_count<T, N + 1>();
+    else
+        return N;
+}
 
-    auto& top_as_sub(bool b = true) noexcept
-    {delims.top_as_sub = b; return *this;}
+inline constexpr std::size_t max_fields = 16; // (that tie_fields() handles)
 
-    auto& as_sub(bool b = true) noexcept // concise alternative; e.g.: delimited(arr).as_sub()
-    {delims.top_as_sub = b; return *this;}
+template <typename T>
+concept aggregate_struct = std::is_class_v<T> && std::is_aggregate_v<T> && !std::ranges::range<T> && field_count<T>() <= max_fields;
 
-    auto& empty(string_view str) noexcept
-    {delims.empty = str; return *this;}
-};
+template <typename T>
+constexpr auto tie_fields(const T& x) noexcept {
+    constexpr auto n = field_count<T>();
+    if constexpr (n == 0) {(void)x; return std::tuple<>{};}
+    else if constexpr (n == 1) {const auto& [a] = x; return std::tie(a);}
+    else if constexpr (n == 2) {const auto& [a, b] = x; return std::tie(a, b);}
+    else if constexpr (n == 3) {const auto& [a, b, c] = x; return std::tie(a, b, c);}
+    else if constexpr (n == 4) {const auto& [a, b, c, d] = x; return std::tie(a, b, c, d);}
+    else if constexpr (n == 5) {const auto& [a, b, c, d, e] = x; return std::tie(a, b, c, d, e);}
+    else if constexpr (n == 6) {const auto& [a, b, c, d, e, f] = x; return std::tie(a, b, c, d, e, f);}
+    else if constexpr (n == 7) {const auto& [a, b, c, d, e, f, g] = x; return std::tie(a, b, c, d, e, f, g);}
+    else if constexpr (n == 8) {const auto& [a, b, c, d, e, f, g, h] = x; return std::tie(a, b, c, d, e, f, g, h);}
+    else if constexpr (n == 9) {const auto& [a, b, c, d, e, f, g, h, i] = x; return std::tie(a, b, c, d, e, f, g, h, i);}
+    else if constexpr (n == 10) {const auto& [a, b, c, d, e, f, g, h, i, j] = x; return std::tie(a, b, c, d, e, f, g, h, i, j);}
+    else if constexpr (n == 11) {const auto& [a, b, c, d, e, f, g, h, i, j, k] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k);}
+    else if constexpr (n == 12) {const auto& [a, b, c, d, e, f, g, h, i, j, k, l] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l);}
+    else if constexpr (n == 13) {const auto& [a, b, c, d, e, f, g, h, i, j, k, l, m] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m);}
+    else if constexpr (n == 14) {const auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, n] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, n);}
+    else if constexpr (n == 15) {const auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, n, o] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o);}
+    else if constexpr (n == 16) {const auto& [a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p] = x; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);}
+}
 
-// sequence, sequence_inserter:
+template <typename T, typename CharT, typename Traits>
+concept struct_like = !ostream_insertable<T, CharT, Traits> && (tuple_like<T> || aggregate_struct<T>);
 
-template <helpers::iterator Iterator>
-struct sequence {
-    Iterator begin_itr, end_itr;
-    Iterator begin() const {return begin_itr;}
-    Iterator end() const {return end_itr;}
-};
+template <typename T>
+constexpr decltype(auto) as_tuple(const T& x) noexcept {
+    if constexpr (is_tuple<T>::value)
+        return (x);
+    else if constexpr (tuple_like<T>)
+        return [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            using std::get;
+            return std::tuple<decltype(get<Is>(x))...>{get<Is>(x)...};
+        }(std::make_index_sequence<std::tuple_size_v<T>>{});
+    else
+        return tie_fields(x);
+}
 
-template <iterator Iterator, typename CharT, typename Traits>
-class sequence_inserter: public inserter<sequence<Iterator>, CharT, Traits> {
-    sequence<Iterator> seq;
-public:
-    sequence_inserter(Iterator begin, Iterator end) noexcept
-        : inserter<sequence<Iterator>, CharT, Traits>{seq} {seq.begin_itr = begin; seq.end_itr = end;}
-    sequence_inserter(Iterator begin, Iterator end, const basic_delimiters<CharT, Traits>& delims) noexcept
-        : inserter<sequence<Iterator>, CharT, Traits>{seq, delims} {seq.begin_itr = begin; seq.end_itr = end;}
+template <typename T>
+using fields_t = std::remove_cvref_t<decltype(as_tuple(std::declval<const T&>()))>;
+
+// iterable_t (T as const if it can be iterated as const, otherwise T; only
+// ranges such as filter_view and istream_view can't be):
+
+template <typename T>
+using iterable_t = std::conditional_t<std::ranges::range<const T> || !std::ranges::range<T>, const T, T>;
+
+// as_iterable (x as iterable_t; so that const and non-const objects of a type
+// are output the same way and share emit instantiations):
+
+template <typename T>
+constexpr iterable_t<std::remove_reference_t<T>>& as_iterable(T&& x) noexcept
+{return x;}
+
+template <typename T, typename CharT, typename Traits>
+struct plan {
+    using type = std::remove_cvref_t<T>;
+
+    static constexpr plan_kind kind =
+        is_string<std::decay_t<type>, CharT, Traits>::value ? plan_kind::string
+        : is_pair<type>::value ? plan_kind::pair
+        : is_tuple<type>::value ? plan_kind::tuple
+        : std::ranges::range<type> ? plan_kind::range
+        : is_optional<type>::value ? plan_kind::optional
+        : is_variant<type>::value ? plan_kind::variant
+        : struct_like<type, CharT, Traits> ? plan_kind::tuple
+        : plan_kind::value;
+
+    static constexpr bool collection = kind == plan_kind::pair || kind == plan_kind::tuple || kind == plan_kind::range;
+
+    // (whether a T may hold a collection; for the wrapper kinds, whether what
+    // they hold may be one)
+    static constexpr bool may_hold_collection = []{
+        if constexpr (kind == plan_kind::optional)
+            return plan<typename type::value_type, CharT, Traits>::may_hold_collection;
+        else if constexpr (kind == plan_kind::variant)
+            return []<std::size_t... Is>(std::index_sequence<Is...>) {
+                return (false || ... || plan<std::tuple_element_t<Is, typename alternatives<type>::types>, CharT, Traits>::may_hold_collection);
+            }(std::make_index_sequence<std::tuple_size_v<typename alternatives<type>::types>>{});
+        else
+            return collection;
+    }();
 };
 
-// default output:
+// is_empty_string (for plan_kind::string):
+
+template <typename T, typename CharT>
+constexpr bool is_empty_string(const T& str) noexcept {
+    if constexpr (requires {str.size();})
+        return str.size() == 0;
+    else
+        return *str == CharT{};
+}
+
+// output primitives for streams (the plan's literal emits and leaf
+// operations):
+
+template <typename CharT, typename Traits>
+inline void put_literal(std::basic_ostream<CharT, Traits>& out, std::basic_string_view<CharT, Traits> str)
+{out << str;}
 
 template <typename CharT, typename Traits, ostream_insertable<CharT, Traits> T>
-inline void output(const T& x, const basic_delimiters<CharT, Traits>&, bool, std::basic_ostream<CharT, Traits>& out)
+inline void put_value(std::basic_ostream<CharT, Traits>& out, const T& x)
 {out << x;}
 
-// output for strings:
+// span output (the fast path for contiguous runs of numbers or strings):
+
+// A range of (at least a few) numbers or strings output to a stream is
+// formatted in bulk if it is contiguous (vector<int>, array<string, N>, etc.;
+// this includes the inner ranges of, e.g., a vector<vector<int>>) or made of
+// contiguous blocks (deque, with libstdc++ outside of its debug mode; see
+// for_each_segment): each block is formatted into a local buffer, with
+// std::to_chars for numbers and a copy for strings, and the buffer is written
+// to the stream buffer in one call, instead of outputting each element and
+// delimiter through the stream's formatted output functions. This is only done
+// when it gives the same result: when the stream's width is 0 and, for
+// numbers, when its format flags are the defaults, its precision is at most 40
+// and its locale's numpunct facet uses '.' as the decimal point and doesn't
+// group digits; otherwise such ranges are output normally.
 
-template <typename CharT, typename Traits>
-inline void output(const CharT* str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out)
-{if (*str) out << str; else out << delims.empty;}
+template <typename T>
+concept character = std::same_as<T, char> || std::same_as<T, signed char> || std::same_as<T, unsigned char>
+    || std::same_as<T, wchar_t> || std::same_as<T, char8_t> || std::same_as<T, char16_t> || std::same_as<T, char32_t>;
 
-template <typename CharT, typename Traits, typename Allocator>
-inline void output(const std::basic_string<CharT, Traits, Allocator>& str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out)
-{if (str.size()) out << str; else out << delims.empty;}
+template <typename T>
+concept span_number = std::is_arithmetic_v<T> && !std::same_as<T, bool> && !character<T>;
 
-template <typename CharT, typename Traits>
-inline void output(const std::basic_string_view<CharT, Traits>& str, const basic_delimiters<CharT, Traits>& delims, bool, std::basic_ostream<CharT, Traits>& out)
-{if (str.size()) out << str; else out << delims.empty;}
+template <typename T, typename CharT, typename Traits>
+concept span_string = is_string<std::decay_t<T>, CharT, Traits>::value;
 
-// output for pair:
+template <typename T, typename CharT, typename Traits>
+concept span_element = span_number<T> || span_string<T, CharT, Traits>;
 
-template <typename T1, typename T2, typename CharT, typename Traits>
-void output(const std::pair<T1, T2>& pair, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out) {
-    if (as_sub)
-        out << delims.pair_prefix;
-    output(pair.first, delims, true, out);
-    out << delims.pair_delim;
-    output(pair.second, delims, true, out);
-    if (as_sub)
-        out << delims.pair_suffix;
+template <typename Out>
+concept ostream = std::derived_from<Out, std::basic_ostream<typename Out::char_type, typename Out::traits_type>>;
+
+template <typename T>
+struct is_segmented: std::false_type {};
+
+// (for_each_segment reads the members of libstdc++'s deque iterator, _M_cur,
+// _M_first, _M_last and _M_node, which aren't part of the standard and aren't
+// accessible through the checked iterator of its debug mode; with other
+// standard libraries, and in that mode, a deque isn't segmented and is output
+// element by element)
+#if defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+template <typename T, typename Allocator>
+struct is_segmented<std::deque<T, Allocator>>: std::true_type {};
+
+// calls f(first, last) for each contiguous block of the deque's elements
+template <typename T, typename Allocator, typename F>
+void for_each_segment(const std::deque<T, Allocator>& deque, F f) {
+    auto first = deque.begin();
+    auto last = deque.end();
+    if (first._M_node == last._M_node)
+        f(first._M_cur, last._M_cur);
+    else {
+        f(first._M_cur, first._M_last);
+        for (auto node = first._M_node + 1; node != last._M_node; ++node)
+            f(*node, *node + first._S_buffer_size());
+        f(last._M_first, last._M_cur);
+    }
 }
+#endif
 
-// output for tuple:
+template <typename T, typename Out>
+concept span_range = ostream<Out>
+    && (std::ranges::contiguous_range<T> || is_segmented<std::remove_cvref_t<T>>::value)
+    && span_element<std::ranges::range_value_t<T>, typename Out::char_type, typename Out::traits_type>;
 
-template<typename... Ts, typename CharT, typename Traits>
-void output(const std::tuple<Ts...>& tuple, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out) {
-    if (as_sub)
-        out << delims.sub_prefix;
-    auto n = sizeof...(Ts);
-    if (n == 0)
-        out << delims.empty;
+template <typename T, typename CharT, typename Traits>
+bool span_output_ok(std::basic_ostream<CharT, Traits>& out) {
+    if (out.width() != 0)
+        return false;
+    if constexpr (span_number<T>) {
+        if ((out.flags() & ~(std::ios_base::skipws | std::ios_base::unitbuf)) != std::ios_base::dec)
+            return false;
+        if (std::is_floating_point_v<T> && out.precision() > 40)
+            return false;
+        const auto& punct = std::use_facet<std::numpunct<CharT>>(out.getloc());
+        return punct.decimal_point() == CharT('.') && punct.grouping().empty();
+    }
+    return true;
+}
+
+// number_chars (the most characters that put_number() outputs for a T):
+
+template <span_number T>
+inline constexpr std::size_t number_chars = std::is_floating_point_v<T>
+    ? 48 // (sign, 40 digits given span_output_ok, point, e, exponent sign and 4 exponent digits)
+    : std::numeric_limits<T>::digits10 + 2; // (sign and digits)
+
+// put_number (formats a number as the stream would given span_output_ok into
+// p, which must have room for number_chars<T> characters; returns the end):
+
+template <span_number T, typename CharT>
+CharT* put_number(CharT* p, T x, std::streamsize precision) noexcept {
+    auto to_chars = [&](char* first) {
+        if constexpr (std::is_floating_point_v<T>)
+            return std::to_chars(first, first + number_chars<T>, x, std::chars_format::general, int(precision)).ptr;
+        else
+            return std::to_chars(first, first + number_chars<T>, x).ptr;
+    };
+    if constexpr (std::same_as<CharT, char>)
+        return to_chars(p);
     else {
-        auto delim = as_sub ? delims.sub_delim : delims.top_delim;
-        auto delim2 = std::basic_string_view<CharT, Traits>();
-        std::apply([&](const auto&... args) {
-            ((out << delim2, output(args, delims, true, out), delim2 = delim), ...);
-        }, tuple);
+        char chars[number_chars<T>];
+        for (auto q = chars, last = to_chars(chars); q != last; ++q)
+            *p++ = CharT(*q);
+        return p;
     }
-    if (as_sub)
-        out << delims.sub_suffix;
 }
 
-// output for range:
+template <typename CharT, typename Traits>
+class span_writer { // writes delimited elements to a stream buffer via a local buffer
+    static constexpr std::size_t capacity = 512;
+    static constexpr std::size_t number_capacity = 64; // enough for any number given span_output_ok
+
+    std::basic_ostream<CharT, Traits>& out;
+    std::basic_string_view<CharT, Traits> delim;
+    std::basic_string_view<CharT, Traits> empty;
+    bool delimit = false; // whether a delimiter goes before the next element
+    std::size_t size = 0;
+    CharT buf[capacity];
+
+    void write(std::basic_string_view<CharT, Traits> str) {
+        if (str.size() > capacity - size) {
+            flush();
+            if (str.size() > capacity) {
+                if (out.rdbuf()->sputn(str.data(), str.size()) != std::streamsize(str.size()))
+                    out.setstate(std::ios_base::badbit);
+                return;
+            }
+        }
+        Traits::copy(buf + size, str.data(), str.size());
+        size += str.size();
+    }
 
-template <std::ranges::range T, typename CharT, typename Traits>
-void output(const T& range, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT, Traits>& out) {
-    if (as_sub)
-        out << delims.sub_prefix;
-    auto begin = range.begin();
-    auto end = range.end();
-    if (begin == end)
-        out << delims.empty;
-    else {
-        auto itr = begin;
-        output(*itr, delims, true, out);
-        auto delim = as_sub ? delims.sub_delim : delims.top_delim;
-        while (++itr != end) {
-            out << delim;
-            output(*itr, delims, true, out);
+    template <span_number T>
+    void write_number(T x) {
+        if (capacity - size < number_capacity)
+            flush();
+        size = put_number(buf + size, x, out.precision()) - buf;
+    }
+
+public:
+    span_writer(std::basic_ostream<CharT, Traits>& out_, std::basic_string_view<CharT, Traits> delim_, std::basic_string_view<CharT, Traits> empty_) noexcept
+        : out{out_}, delim{delim_}, empty{empty_} {}
+
+    template <typename T>
+    void write(const T* first, const T* last) {
+        for (; first != last && out; ++first) { // (stops if out fails, as emit_elements does)
+            if (delimit)
+                write(delim);
+            delimit = true;
+            if constexpr (span_number<T>)
+                write_number(*first);
+            else if (is_empty_string<T, CharT>(*first))
+                write(empty);
+            else
+                write(std::basic_string_view<CharT, Traits>(*first));
         }
     }
-    if (as_sub)
-        out << delims.sub_suffix;
+
+    void flush() {
+        if (size && out.rdbuf()->sputn(buf, size) != std::streamsize(size))
+            out.setstate(std::ios_base::badbit);
+        size = 0;
+    }
+};
+
+// outputs the elements of a nonempty span_range; returns false (without
+// outputting anything) if span_output_ok says no or if the range is too short
+// for bulk output to pay off
+template <typename T, typename CharT, typename Traits>
+bool put_span_range(const T& range, std::basic_string_view<CharT, Traits> delim, const basic_delimiters<CharT, Traits>& delims, std::basic_ostream<CharT, Traits>& out) {
+    constexpr std::size_t min_size = 4;
+    if (std::ranges::size(range) < min_size || !span_output_ok<std::ranges::range_value_t<T>>(out))
+        return false;
+    typename std::basic_ostream<CharT, Traits>::sentry sentry{out};
+    if (sentry) {
+        auto writer = span_writer<CharT, Traits>{out, delim, delims.empty};
+        if constexpr (std::ranges::contiguous_range<T>)
+            writer.write(std::ranges::data(range), std::ranges::data(range) + std::ranges::size(range));
+        else
+            for_each_segment(range, [&](auto first, auto last) {writer.write(first, last);});
+        writer.flush();
+    }
+    return true;
 }
 
-} // namespace helpers
-} // namespace delimited_output
+// as_span (in the type-erased build, presents a contiguous range as a span of
+// its elements, so that all the contiguous ranges of an element type share
+// one instantiation of put_span_range; otherwise, and for other ranges,
+// returns the range itself):
+
+template <typename T>
+constexpr decltype(auto) as_span(const T& range) noexcept {
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+    if constexpr (std::ranges::contiguous_range<const T>)
+        return std::span{std::ranges::data(range), std::ranges::size(range)};
+    else
+#endif
+        return (range);
+}
+
+// fixed-extent output (the fast path for small arrays of numbers):
+
+// A std::array, C array or std::span with a static extent of up to 64 numbers
+// (or, for char streams, characters) output to a stream is formatted by an
+// unrolled sequence of to_chars calls into a stack buffer sized at
+// compile-time for the widest output of its elements (given a delimiter of up
+// to 8 characters), without any bounds checks, and written to the stream
+// buffer in one call; the conditions are otherwise those of span output.
+
+template <typename T>
+struct fixed_extent: std::integral_constant<std::size_t, 0> {};
+
+template <typename T, std::size_t N>
+struct fixed_extent<std::array<T, N>>: std::integral_constant<std::size_t, N> {};
+
+template <typename T, std::size_t N>
+struct fixed_extent<T[N]>: std::integral_constant<std::size_t, N> {};
+
+template <typename T, std::size_t N> requires (N != std::dynamic_extent)
+struct fixed_extent<std::span<T, N>>: std::integral_constant<std::size_t, N> {};
+
+template <typename T, typename CharT>
+concept fixed_element = span_number<T> || (std::same_as<CharT, char> && character<T> && sizeof(T) == 1);
+
+template <typename T, typename Out>
+concept fixed_range = ostream<Out>
+    && fixed_extent<std::remove_cvref_t<T>>::value != 0 && fixed_extent<std::remove_cvref_t<T>>::value <= 64
+    && fixed_element<std::remove_cv_t<std::ranges::range_value_t<T>>, typename Out::char_type>;
+
+// outputs the elements of a fixed_range; returns false (without outputting
+// anything) if span_output_ok says no or if the delimiter is too long
+template <typename T, typename CharT, typename Traits>
+bool put_fixed_range(const T& range, std::basic_string_view<CharT, Traits> delim, std::basic_ostream<CharT, Traits>& out) {
+    using element = std::remove_cv_t<std::ranges::range_value_t<T>>;
+    constexpr std::size_t n = fixed_extent<std::remove_cvref_t<T>>::value;
+    constexpr std::size_t max_delim = 8;
+    constexpr std::size_t element_chars = [] {
+        if constexpr (span_number<element>)
+            return number_chars<element>;
+        else
+            return std::size_t{1};
+    }();
+    if (delim.size() > max_delim || !span_output_ok<element>(out))
+        return false;
+    typename std::basic_ostream<CharT, Traits>::sentry sentry{out};
+    if (sentry) {
+        CharT buf[n * (element_chars + max_delim)];
+        auto p = buf;
+        auto precision = out.precision();
+        const auto* x = std::ranges::data(range);
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ([&] {
+                if constexpr (Is != 0) {
+                    Traits::copy(p, delim.data(), delim.size());
+                    p += delim.size();
+                }
+                if constexpr (span_number<element>)
+                    p = put_number(p, x[Is], precision);
+                else
+                    *p++ = CharT(x[Is]);
+            }(), ...);
+        }(std::make_index_sequence<n>{});
+        if (out.rdbuf()->sputn(buf, p - buf) != p - buf)
+            out.setstate(std::ios_base::badbit);
+    }
+    return true;
+}
+
+// type-erased output primitives (DELIMITED_OUTPUT_TYPE_ERASED build mode):
+
+// When DELIMITED_OUTPUT_TYPE_ERASED is defined, leaves, strings and literals
+// output to std::ostream or std::wostream go through the non-template
+// functions declared in helpers::erased below, ranges other than those output
+// in bulk as spans are traversed by the shared erased::traverse function
+// through a type-erased cursor, so each distinct container type only
+// instantiates a pair of small out-of-line thunks instead of a full copy of
+// the traversal and stream insertion code, and the ranges output as spans are
+// output via a span of their elements, so that they share one instantiation
+// per element type (small arrays aren't unrolled); also, the layout of tables
+// (table_layout) and the scratch streams (scratch_stream and scratch()) are
+// declared extern template, for char and wchar_t, so that their code is
+// compiled once instead of being inlined into each caller. The functions and
+// instances are defined in delimited_output.cpp, which must then be compiled
+// and linked in; the macro must be defined consistently for every translation
+// unit of a program.
+// (See the size-report target in the Makefile for the effect on code size.)
+
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+
+// (keeps the compiler from inlining the per-type functions behind an
+// erased::range, which would bring back a copy of the traversal for each type)
+#if defined(__GNUC__)
+#define DELIMITED_OUTPUT_NOINLINE [[gnu::noinline]]
+#else
+#define DELIMITED_OUTPUT_NOINLINE
+#endif
+
+#define DELIMITED_OUTPUT_ERASED_LEAF_TYPES(X) \
+    X(bool) X(char) X(signed char) X(unsigned char) \
+    X(short) X(unsigned short) X(int) X(unsigned int) \
+    X(long) X(unsigned long) X(long long) X(unsigned long long) \
+    X(float) X(double) X(long double)
+
+namespace erased {
+
+#define DELIMITED_OUTPUT_DECLARE_ERASED_LEAF(T) \
+    void put_leaf(std::ostream& out, T x); \
+    void put_leaf(std::wostream& out, T x);
+DELIMITED_OUTPUT_ERASED_LEAF_TYPES(DELIMITED_OUTPUT_DECLARE_ERASED_LEAF)
+#undef DELIMITED_OUTPUT_DECLARE_ERASED_LEAF
+
+void put_leaf(std::wostream& out, wchar_t x);
+void put_leaf(std::ostream& out, std::string_view str);
+void put_leaf(std::wostream& out, std::wstring_view str);
+
+template <typename CharT>
+struct range { // type-erased cursor over the elements of a range
+    void* state;
+    bool (*done)(void* state);
+    void (*output_next)(void* state, std::basic_ostream<CharT>& out); // outputs current element as sub-level and advances
+};
+
+void traverse(const range<char>& range, const basic_delimiters<char>& delims, bool as_sub, std::ostream& out);
+void traverse(const range<wchar_t>& range, const basic_delimiters<wchar_t>& delims, bool as_sub, std::wostream& out);
+
+} // namespace erased
+
+void put_literal(std::ostream& out, std::string_view str);
+void put_literal(std::wostream& out, std::wstring_view str);
+
+template <typename T, typename CharT, typename Traits>
+concept erased_leaf = std::is_arithmetic_v<T> && std::same_as<Traits, std::char_traits<CharT>>
+    && requires(std::basic_ostream<CharT>& out, T x) {erased::put_leaf(out, x);};
+
+template <typename T, typename CharT, typename Traits>
+concept erased_string = is_string<std::decay_t<T>, CharT, Traits>::value && std::same_as<Traits, std::char_traits<CharT>>
+    && requires(std::basic_ostream<CharT>& out, const T& str) {erased::put_leaf(out, std::basic_string_view<CharT>{str});};
+
+template <typename T, typename Out>
+concept erased_traversable = std::ranges::range<const T> && !span_range<T, Out>
+    && (std::same_as<Out, std::ostream> || std::same_as<Out, std::wostream>);
+
+template <typename CharT, typename Traits, ostream_insertable<CharT, Traits> T> requires erased_leaf<T, CharT, Traits>
+inline void put_value(std::basic_ostream<CharT, Traits>& out, const T& x)
+{erased::put_leaf(out, x);}
+
+template <typename CharT, typename Traits, ostream_insertable<CharT, Traits> T> requires erased_string<T, CharT, Traits>
+inline void put_value(std::basic_ostream<CharT, Traits>& out, const T& str)
+{erased::put_leaf(out, std::basic_string_view<CharT>{str});}
+
+#endif // DELIMITED_OUTPUT_TYPE_ERASED
+
+// prefetcher (for node-based ranges; see basic_delimiters::prefetch):
+
+// (containers only: a second iterator over a view such as a filter_view would
+// evaluate its elements twice)
+template <typename T>
+concept node_based_range = std::ranges::forward_range<T> && !std::ranges::random_access_range<T>
+    && requires {typename std::remove_cvref_t<T>::allocator_type;};
+
+template <typename CharT, typename Traits>
+class realtime_sink;
+
+// (realtime output ignores the prefetch setting)
+template <typename Out>
+struct is_realtime_sink: std::false_type {};
+
+template <typename CharT, typename Traits>
+struct is_realtime_sink<realtime_sink<CharT, Traits>>: std::true_type {};
+
+template <std::forward_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+class prefetcher {
+    Iterator ahead;
+    Sentinel end;
+
+    void prefetch_ahead() noexcept {
+#if defined(__GNUC__)
+        __builtin_prefetch(std::addressof(*ahead));
+#endif
+    }
+
+public:
+    prefetcher(Iterator itr, Sentinel end_, std::size_t distance)
+        : ahead{itr}, end{end_} {
+        for (; distance && ahead != end; --distance)
+            advance();
+    }
+
+    // (a node is prefetched when ahead reaches it and loaded when ahead
+    // leaves it, at the next call, so the load has an element's output to
+    // complete in)
+    void advance() { // call once per element output
+        if (ahead != end && ++ahead != end)
+            prefetch_ahead();
+    }
+};
+
+struct no_prefetcher {
+    constexpr void advance() noexcept {}
+};
+
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+
+// optional_prefetcher (for a range that can be prefetched along, an optional
+// prefetcher; for others, a no_prefetcher):
+
+template <typename T>
+struct optional_prefetcher {using type = no_prefetcher;};
+
+template <node_based_range T>
+struct optional_prefetcher<T> {using type = std::optional<prefetcher<std::ranges::iterator_t<const T>, std::ranges::sentinel_t<const T>>>;};
+
+// erased_cursor (iteration state and thunks behind an erased::range; these
+// don't depend on AsSub so top- and sub-level output of a range share them):
+
+template <bool AsSub, typename T, typename CharT, typename Traits, typename Out>
+constexpr void emit(T&& x, const basic_delimiters<CharT, Traits>& delims, Out& out);
+
+template <typename T, typename CharT, typename Traits>
+struct erased_cursor {
+    std::ranges::iterator_t<const T> itr;
+    std::ranges::sentinel_t<const T> end;
+    const basic_delimiters<CharT, Traits>* delims;
+    typename optional_prefetcher<T>::type ahead;
+
+    erased_cursor(const T& range, const basic_delimiters<CharT, Traits>& delims_)
+        : itr{std::ranges::begin(range)}, end{std::ranges::end(range)}, delims{&delims_} {
+        if constexpr (node_based_range<T>)
+            if (delims_.prefetch)
+                ahead.emplace(itr, end, delims_.prefetch);
+    }
+
+    DELIMITED_OUTPUT_NOINLINE static bool done(void* p) {
+        auto& cursor = *static_cast<erased_cursor*>(p);
+        return cursor.itr == cursor.end;
+    }
+
+    DELIMITED_OUTPUT_NOINLINE static void output_next(void* p, std::basic_ostream<CharT>& out) {
+        auto& cursor = *static_cast<erased_cursor*>(p);
+        if constexpr (node_based_range<T>)
+            if (cursor.ahead)
+                cursor.ahead->advance();
+        emit<true>(as_iterable(*cursor.itr), *cursor.delims, out);
+        ++cursor.itr;
+    }
+};
+
+// (outputs a range through an erased_cursor; out of line, and taking as_sub at
+// run time, so that every range of a type shares one copy)
+template <typename T, typename CharT, typename Traits>
+DELIMITED_OUTPUT_NOINLINE void emit_erased(const T& x, const basic_delimiters<CharT, Traits>& delims, bool as_sub, std::basic_ostream<CharT>& out) {
+    auto cursor = erased_cursor<T, CharT, Traits>{x, delims};
+    auto range = erased::range<CharT>{&cursor, &erased_cursor<T, CharT, Traits>::done, &erased_cursor<T, CharT, Traits>::output_next};
+    erased::traverse(range, delims, as_sub, out);
+}
+
+#endif // DELIMITED_OUTPUT_TYPE_ERASED
+
+// emit_elements (outputs the elements of a nonempty range for emit, advancing
+// a prefetcher along with them if one is given):
+
+template <typename Iterator, typename Sentinel, typename CharT, typename Traits, typename Out, typename Prefetcher = no_prefetcher>
+constexpr void emit_elements(Iterator itr, Sentinel end, std::basic_string_view<CharT, Traits> delim, const basic_delimiters<CharT, Traits>& delims, Out& out, Prefetcher ahead = {});
+
+// variant_dispatch (a table, generated at compile-time, of the functions that
+// emit each alternative of a variant-like type, indexed by the active one):
+
+template <bool AsSub, typename T, typename CharT, typename Traits, typename Out, typename = std::make_index_sequence<std::tuple_size_v<typename alternatives<T>::types>>>
+struct variant_dispatch;
+
+// emit (executes the plan for a T; AsSub is true for everything but the
+// outermost collection and for it when top_as_sub is set):
+
+template <bool AsSub, typename T, typename CharT, typename Traits, typename Out>
+constexpr void emit(T&& x, const basic_delimiters<CharT, Traits>& delims, Out& out) {
+    using type = std::remove_cvref_t<T>;
+    using plan = helpers::plan<type, CharT, Traits>;
+    const auto& delim = AsSub ? delims.sub_delim : delims.top_delim;
+
+    if constexpr (plan::kind == plan_kind::value)
+        put_value(out, x);
+
+    else if constexpr (plan::kind == plan_kind::string) {
+        if (is_empty_string<T, CharT>(x))
+            put_literal(out, delims.empty);
+        else
+            put_value(out, x);
+    }
+
+    else if constexpr (plan::kind == plan_kind::pair) {
+        if constexpr (AsSub)
+            put_literal(out, delims.pair_prefix);
+        emit<true>(x.first, delims, out);
+        put_literal(out, delims.pair_delim);
+        emit<true>(x.second, delims, out);
+        if constexpr (AsSub)
+            put_literal(out, delims.pair_suffix);
+    }
+
+    else if constexpr (plan::kind == plan_kind::tuple) {
+        if constexpr (AsSub)
+            put_literal(out, delims.sub_prefix);
+        if constexpr (std::tuple_size_v<fields_t<type>> == 0)
+            put_literal(out, delims.empty);
+        else
+            std::apply([&](const auto& first, const auto&... rest) {
+                emit<true>(first, delims, out);
+                ((put_literal(out, delim), emit<true>(rest, delims, out)), ...);
+            }, as_tuple(x));
+        if constexpr (AsSub)
+            put_literal(out, delims.sub_suffix);
+    }
+
+    else if constexpr (plan::kind == plan_kind::optional) {
+        if (x)
+            emit<AsSub>(as_iterable(*x), delims, out);
+        else
+            put_literal(out, delims.none);
+    }
+
+    else if constexpr (plan::kind == plan_kind::variant) {
+        using dispatch = variant_dispatch<AsSub, type, CharT, Traits, Out>;
+        auto i = alternatives<type>::index(x);
+        if (i < std::size(dispatch::table))
+            dispatch::table[i](x, delims, out);
+        else
+            put_literal(out, delims.none);
+    }
+
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+    else if constexpr (erased_traversable<type, Out>)
+        emit_erased(x, delims, AsSub, out);
+#endif
+
+    else { // plan_kind::range
+        if constexpr (AsSub)
+            put_literal(out, delims.sub_prefix);
+        auto itr = std::ranges::begin(x);
+        auto end = std::ranges::end(x);
+        if (itr == end)
+            put_literal(out, delims.empty);
+#ifndef DELIMITED_OUTPUT_TYPE_ERASED // (output as spans instead)
+        else if constexpr (fixed_range<type, Out>) {
+            if (!put_fixed_range(x, delim, out))
+                emit_elements(itr, end, delim, delims, out);
+        }
+#endif
+        else if constexpr (span_range<type, Out>) {
+            if (!put_span_range(as_span(x), delim, delims, out))
+                emit_elements(itr, end, delim, delims, out);
+        }
+        else if constexpr (node_based_range<type> && !is_realtime_sink<Out>::value) {
+            if (delims.prefetch)
+                emit_elements(itr, end, delim, delims, out, prefetcher{itr, end, delims.prefetch});
+            else
+                emit_elements(itr, end, delim, delims, out);
+        }
+        else
+            emit_elements(std::move(itr), end, delim, delims, out); // (may be move-only)
+        if constexpr (AsSub)
+            put_literal(out, delims.sub_suffix);
+    }
+}
+
+template <bool AsSub, typename T, typename CharT, typename Traits, typename Out, std::size_t... Is>
+struct variant_dispatch<AsSub, T, CharT, Traits, Out, std::index_sequence<Is...>> {
+    template <std::size_t I>
+    static constexpr void emit_alternative(const T& x, const basic_delimiters<CharT, Traits>& delims, Out& out) {
+        if constexpr (std::same_as<std::tuple_element_t<I, typename alternatives<T>::types>, std::monostate>)
+            put_literal(out, delims.none);
+        else
+            emit<AsSub>(as_iterable(*alternatives<T>::template get<I>(x)), delims, out);
+    }
+
+    static constexpr void (*table[])(const T&, const basic_delimiters<CharT, Traits>&, Out&) = {&emit_alternative<Is>...};
+};
+
+template <typename Iterator, typename Sentinel, typename CharT, typename Traits, typename Out, typename Prefetcher>
+constexpr void emit_elements(Iterator itr, Sentinel end, std::basic_string_view<CharT, Traits> delim, const basic_delimiters<CharT, Traits>& delims, Out& out, Prefetcher ahead) {
+    ahead.advance();
+    emit<true>(as_iterable(*itr), delims, out);
+    while (++itr != end && out) { // (stops if out fails, e.g., when it can't take any more)
+        ahead.advance();
+        put_literal(out, delim);
+        emit<true>(as_iterable(*itr), delims, out);
+    }
+}
+
+// string_buf (stream buffer that appends its output to a string):
+
+template <typename CharT, typename Traits>
+class string_buf: public std::basic_streambuf<CharT, Traits> {
+    std::basic_string<CharT, Traits> str_;
+
+protected:
+    using int_type = typename Traits::int_type;
+
+    int_type overflow(int_type c) override {
+        if (!Traits::eq_int_type(c, Traits::eof()))
+            str_.push_back(Traits::to_char_type(c));
+        return Traits::not_eof(c);
+    }
+
+    std::streamsize xsputn(const CharT* s, std::streamsize n) override {
+        str_.append(s, n);
+        return n;
+    }
+
+public:
+    std::basic_string<CharT, Traits>& str() noexcept {return str_;}
+    std::basic_string_view<CharT, Traits> view() const noexcept {return str_;}
+    void clear() noexcept {str_.clear();} // keeps capacity
+};
+
+// scratch (the calling thread's scratch stream and the buffer it outputs to, for
+// formatting output in full before writing it anywhere; start() and scratch()
+// are defined out of class and not inline, so that the type-erased build can
+// compile them once into delimited_output.cpp instead of into each caller):
+
+template <typename CharT, typename Traits, typename Buf = string_buf<CharT, Traits>>
+struct scratch_stream {
+    Buf buf;
+    std::basic_ostream<CharT, Traits> out{&buf};
+
+    // empties the buffer and gives the stream the formatting state and locale
+    // of another stream, or the default ones
+    void start(const std::basic_ios<CharT, Traits>& like);
+    void start();
+};
+
+template <typename CharT, typename Traits, typename Buf>
+void scratch_stream<CharT, Traits, Buf>::start(const std::basic_ios<CharT, Traits>& like) {
+    buf.clear();
+    out.flags(like.flags());
+    out.precision(like.precision());
+    out.fill(like.fill());
+    out.width(like.width());
+    if (out.getloc() != like.getloc())
+        out.imbue(like.getloc());
+}
+
+template <typename CharT, typename Traits, typename Buf>
+void scratch_stream<CharT, Traits, Buf>::start() {
+    buf.clear();
+    out.flags(std::ios_base::dec | std::ios_base::skipws);
+    out.precision(6);
+    out.fill(out.widen(' '));
+    out.width(0);
+    if (out.getloc() != std::locale{})
+        out.imbue(std::locale{});
+}
+
+template <typename CharT, typename Traits>
+scratch_stream<CharT, Traits>& scratch() {
+    static thread_local scratch_stream<CharT, Traits> stream;
+    return stream;
+}
+
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+extern template struct scratch_stream<char, std::char_traits<char>>;
+extern template struct scratch_stream<wchar_t, std::char_traits<wchar_t>>;
+extern template scratch_stream<char, std::char_traits<char>>& scratch();
+extern template scratch_stream<wchar_t, std::char_traits<wchar_t>>& scratch();
+#endif
+
+// output_table (outputs a range of collections as a table: each collection is a
+// row, its elements are the cells, and each column is padded to its widest
+// cell; the cells are formatted once, into a table_layout's arena, to measure
+// them, and then output from there; an empty row is output as the empty
+// text):
+
+template <typename T, typename CharT, typename Traits>
+concept table = plan<T, CharT, Traits>::kind == plan_kind::range
+    && plan<std::ranges::range_reference_t<iterable_t<T>>, CharT, Traits>::collection;
+
+template <typename Row, typename F>
+void for_each_cell(Row&& row, F&& f) {
+    using type = std::remove_cvref_t<Row>;
+    if constexpr (is_pair<type>::value) {
+        f(row.first);
+        f(row.second);
+    }
+    else if constexpr (std::ranges::range<type>)
+        for (auto&& cell: row)
+            f(as_iterable(cell));
+    else
+        std::apply([&](const auto&... cells) {(f(cells), ...);}, as_tuple(row));
+}
+
+// (the part of a table's output that doesn't depend on its type: the arena,
+// the cells' extents and the columns' widths, and their layout; its members
+// are defined out of class, so that the type-erased build can compile them
+// once into delimited_output.cpp instead of into each table's output)
+template <typename CharT, typename Traits>
+class table_layout {
+    struct cell {std::size_t offset, size;};
+
+    scratch_stream<CharT, Traits> arena;
+    std::vector<cell> cells;
+    std::vector<std::size_t> row_ends; // (index in cells of the end of each row)
+    std::vector<std::size_t> widths;
+    std::size_t column = 0;
+    std::size_t offset = 0; // (of the cell being formatted)
+
+public:
+    explicit table_layout(std::basic_ostream<CharT, Traits>& out);
+
+    // (returns the stream to format the next cell of the current row to)
+    std::basic_ostream<CharT, Traits>& begin_cell() noexcept {
+        offset = arena.buf.view().size();
+        return arena.out;
+    }
+
+    void end_cell();
+    void end_row();
+    void put(std::basic_ostream<CharT, Traits>& out, const basic_delimiters<CharT, Traits>& delims) const;
+};
+
+template <typename CharT, typename Traits>
+table_layout<CharT, Traits>::table_layout(std::basic_ostream<CharT, Traits>& out) {
+    arena.start(out);
+    arena.out.width(0);
+    out.width(0);
+}
+
+template <typename CharT, typename Traits>
+void table_layout<CharT, Traits>::end_cell() {
+    auto size = arena.buf.view().size() - offset;
+    cells.push_back({offset, size});
+    if (column == widths.size())
+        widths.resize(column + 1);
+    widths[column] = std::max(widths[column], size);
+    ++column;
+}
+
+template <typename CharT, typename Traits>
+void table_layout<CharT, Traits>::end_row() {
+    row_ends.push_back(cells.size());
+    column = 0;
+}
+
+template <typename CharT, typename Traits>
+void table_layout<CharT, Traits>::put(std::basic_ostream<CharT, Traits>& out, const basic_delimiters<CharT, Traits>& delims) const {
+    if (row_ends.empty()) {
+        put_literal(out, delims.empty);
+        return;
+    }
+
+    auto text = arena.buf.view();
+    auto max_width = widths.empty() ? 0 : *std::max_element(widths.begin(), widths.end());
+    auto padding = std::basic_string<CharT, Traits>(max_width, out.fill());
+    auto pad = [&](std::size_t n) {if (n) put_literal(out, std::basic_string_view<CharT, Traits>{padding.data(), n});};
+    bool right = (out.flags() & std::ios_base::adjustfield) == std::ios_base::right;
+    std::size_t row_begin = 0;
+    for (std::size_t row = 0; row != row_ends.size(); ++row) {
+        auto row_end = row_ends[row];
+        if (row)
+            put_literal(out, delims.top_delim);
+        if (row_begin == row_end)
+            put_literal(out, delims.empty);
+        for (auto i = row_begin; i != row_end; ++i) {
+            auto column = i - row_begin;
+            if (column)
+                put_literal(out, delims.column_delim);
+            if (right)
+                pad(widths[column] - cells[i].size);
+            put_literal(out, text.substr(cells[i].offset, cells[i].size));
+            if (!right && i + 1 != row_end) // (no trailing padding)
+                pad(widths[column] - cells[i].size);
+        }
+        row_begin = row_end;
+    }
+}
+
+#ifdef DELIMITED_OUTPUT_TYPE_ERASED
+extern template class table_layout<char, std::char_traits<char>>;
+extern template class table_layout<wchar_t, std::char_traits<wchar_t>>;
+#endif
+
+template <typename T, typename CharT, typename Traits, typename Out>
+void output_table(T& x, const basic_delimiters<CharT, Traits>& delims, Out& out) {
+    auto layout = table_layout<CharT, Traits>{out};
+    for (auto&& row: x) {
+        for_each_cell(as_iterable(row), [&](const auto& x) {
+            emit<true>(x, delims, layout.begin_cell());
+            layout.end_cell();
+        });
+        layout.end_row();
+    }
+    layout.put(out, delims);
+}
+
+// output_sorted (outputs an unordered associative container in key order via
+// a sorted array of pointers to its elements; integer keys of up to 32 bits
+// are radix sorted, and with a limit, only that many are sorted):
+
+template <typename T>
+concept unordered_associative = std::ranges::forward_range<const T> && requires {
+    typename T::key_type;
+    typename T::hasher;
+};
+
+// (sorted is only honored for keys that have <; others keep hash order, so
+// that, e.g., an unordered_set of a type with only == and a hash still
+// compiles)
+template <typename T>
+concept sortable_unordered = unordered_associative<T>
+    && requires(const typename T::key_type& a, const typename T::key_type& b) {{a < b} -> std::convertible_to<bool>;};
+
+template <typename Element>
+constexpr const auto& sort_key(const Element& x) noexcept {
+    if constexpr (is_pair<Element>::value)
+        return x.first;
+    else
+        return x;
+}
+
+// (for wider keys, the extra passes cost more than comparison sorting saves)
+template <typename Key>
+concept radix_key = std::is_integral_v<Key> && !std::same_as<Key, bool> && sizeof(Key) <= 4;
+
+// (LSD radix sort, a byte at a time, of the keys paired with the pointers, so
+// that the passes don't revisit the elements; skips bytes that are the same
+// for all keys)
+template <typename Element>
+void radix_sort(std::vector<const Element*>& ptrs) {
+    using key = std::remove_cvref_t<decltype(sort_key(std::declval<const Element&>()))>;
+    using bits = std::make_unsigned_t<key>;
+    struct item {bits key; const Element* ptr;};
+    constexpr auto flip = std::is_signed_v<key> ? bits(bits(1) << (sizeof(key) * 8 - 1)) : bits(0);
+    auto items = std::vector<item>(ptrs.size());
+    auto tmp = std::vector<item>(ptrs.size());
+    for (std::size_t i = 0; i < ptrs.size(); ++i)
+        items[i] = {bits(bits(sort_key(*ptrs[i])) ^ flip), ptrs[i]};
+    for (std::size_t shift = 0; shift < sizeof(key) * 8; shift += 8) {
+        auto digit = [&](const item& x) {return std::size_t(x.key >> shift & 0xff);};
+        std::size_t counts[257] = {};
+        for (const auto& x: items)
+            ++counts[digit(x) + 1];
+        if (counts[digit(items.front()) + 1] == items.size())
+            continue;
+        for (std::size_t i = 1; i < 257; ++i)
+            counts[i] += counts[i - 1];
+        for (const auto& x: items)
+            tmp[counts[digit(x)]++] = x;
+        items.swap(tmp);
+    }
+    for (std::size_t i = 0; i < ptrs.size(); ++i)
+        ptrs[i] = items[i].ptr;
+}
+
+template <typename T, typename CharT, typename Traits, typename Out>
+void output_sorted(T& x, const basic_delimiters<CharT, Traits>& delims, bool as_sub, Out& out) {
+    using element = std::remove_cvref_t<std::ranges::range_reference_t<T>>;
+    auto ptrs = std::vector<const element*>{};
+    ptrs.reserve(std::ranges::distance(x));
+    for (const auto& elem: x)
+        ptrs.push_back(&elem);
+
+    auto less = [](const element* a, const element* b) {return sort_key(*a) < sort_key(*b);};
+    auto n = std::min(ptrs.size(), delims.sorted_limit);
+    if (n < ptrs.size())
+        std::partial_sort(ptrs.begin(), ptrs.begin() + n, ptrs.end(), less);
+    else if constexpr (radix_key<std::remove_cvref_t<decltype(sort_key(std::declval<const element&>()))>>) {
+        if (ptrs.size() >= 64)
+            radix_sort(ptrs);
+        else
+            std::sort(ptrs.begin(), ptrs.end(), less);
+    }
+    else
+        std::sort(ptrs.begin(), ptrs.end(), less);
+
+    auto elements = std::views::transform(std::views::counted(ptrs.begin(), n), [](const element* p) -> const element& {return *p;});
+    if (as_sub)
+        emit<true>(elements, delims, out);
+    else
+        emit<false>(elements, delims, out);
+}
+
+// output (resolves as_sub for the outermost collection and runs the plan):
+
+template <typename T, typename CharT, typename Traits, typename Out>
+inline void output(T& x, const basic_delimiters<CharT, Traits>& delims, bool as_sub, Out& out) {
+    if constexpr (sortable_unordered<std::remove_cv_t<T>>) {
+        if (delims.sorted) {
+            output_sorted(x, delims, as_sub, out);
+            return;
+        }
+    }
+    if constexpr (table<T, CharT, Traits>) {
+        if (delims.table) {
+            output_table(x, delims, out);
+            return;
+        }
+    }
+    if constexpr (plan<T, CharT, Traits>::may_hold_collection) {
+        if (as_sub)
+            emit<true>(x, delims, out);
+        else
+            emit<false>(x, delims, out);
+    }
+    else
+        emit<false>(x, delims, out);
+}
+
+// put_text (outputs text to a stream's buffer with a single sputn):
+
+template <typename CharT, typename Traits>
+void put_text(std::basic_ostream<CharT, Traits>& out, std::basic_string_view<CharT, Traits> text) {
+    if (typename std::basic_ostream<CharT, Traits>::sentry ok{out}; ok && out.rdbuf()->sputn(text.data(), text.size()) != std::streamsize(text.size()))
+        out.setstate(std::ios_base::badbit);
+}
+
+// output_atomic (formats an object into the scratch stream with out's
+// formatting state, then outputs the text to out with a single sputn; when out
+// is the scratch stream, i.e., for an atomic object nested in another, just
+// outputs the object):
+
+template <typename T, typename CharT, typename Traits>
+void output_atomic(std::basic_ostream<CharT, Traits>& out, T& x, const basic_delimiters<CharT, Traits>& delims) {
+    auto& scratch = helpers::scratch<CharT, Traits>();
+    if (&out == &scratch.out) {
+        output(x, delims, delims.top_as_sub, out);
+        put_literal(out, delims.terminator);
+        return;
+    }
+    scratch.start(out);
+    output(x, delims, delims.top_as_sub, scratch.out);
+    put_literal(scratch.out, delims.terminator);
+    out.width(0);
+    put_text(out, scratch.buf.view());
+}
+
+// hash_bytes (a fast, non-cryptographic 64-bit hash, 8 bytes at a time; a
+// previous hash given as the seed chains blocks of data):
+
+inline std::uint64_t hash_bytes(const void* data, std::size_t n, std::uint64_t seed = 0) noexcept {
+    constexpr std::uint64_t k1 = 0xff51afd7ed558ccd, k2 = 0xc4ceb9fe1a85ec53;
+    auto p = static_cast<const unsigned char*>(data);
+    std::uint64_t h = 0x9e3779b97f4a7c15 ^ seed ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        h ^= w * k1;
+        h = ((h << 31) | (h >> 33)) * k2;
+    }
+    std::uint64_t w = 0;
+    if (n)
+        std::memcpy(&w, p, n);
+    h ^= w * k1;
+    h ^= h >> 33;
+    h *= k2;
+    return h ^ (h >> 33);
+}
+
+#ifdef DELIMITED_OUTPUT_HAS_WRITE_FD
+
+// write_fd (for delimited_write()):
+
+template <typename Object>
+bool write_fd(int fd, const Object& obj, const delimiters& delims, std::string_view terminator) {
+    auto& scratch = helpers::scratch<char, std::char_traits<char>>();
+    scratch.start();
+    output(obj, delims, delims.top_as_sub, scratch.out);
+    put_literal(scratch.out, terminator);
+    for (auto text = scratch.buf.view(); !text.empty();) {
+        auto n = ::write(fd, text.data(), text.size());
+        if (n < 0 && errno != EINTR)
+            return false;
+        if (n > 0)
+            text.remove_prefix(std::size_t(n));
+    }
+    return true;
+}
+
+#endif // DELIMITED_OUTPUT_HAS_WRITE_FD
+
+// fixed_buf (stream buffer that writes to a character buffer of a fixed size
+// and fails, noting it, when that's full):
+
+template <typename CharT, typename Traits>
+class fixed_buf: public std::basic_streambuf<CharT, Traits> {
+    bool full_ = false;
+
+protected:
+    using int_type = typename Traits::int_type;
+
+    int_type overflow(int_type c) override {
+        if (!Traits::eq_int_type(c, Traits::eof()))
+            full_ = true;
+        return Traits::eof();
+    }
+
+    std::streamsize xsputn(const CharT* s, std::streamsize n) override {
+        auto room = std::streamsize(this->epptr() - this->pptr());
+        if (n > room) {
+            n = room;
+            full_ = true;
+        }
+        Traits::copy(this->pptr(), s, std::size_t(n));
+        this->setp(this->pptr() + n, this->epptr());
+        return n;
+    }
+
+public:
+    fixed_buf(CharT* buf, std::size_t n) noexcept {this->setp(buf, buf + n);}
+
+    CharT* end() const noexcept {return this->pptr();}
+    bool full() const noexcept {return full_;}
+};
+
+// size_buf (stream buffer that only counts its output):
+
+template <typename CharT, typename Traits>
+class size_buf: public std::basic_streambuf<CharT, Traits> {
+    std::size_t size_ = 0;
+
+protected:
+    using int_type = typename Traits::int_type;
+
+    int_type overflow(int_type c) override {
+        if (!Traits::eq_int_type(c, Traits::eof()))
+            ++size_;
+        return Traits::not_eof(c);
+    }
+
+    std::streamsize xsputn(const CharT*, std::streamsize n) override {
+        size_ += std::size_t(n);
+        return n;
+    }
+
+public:
+    std::size_t size() const noexcept {return size_;}
+};
+
+// hash_buf (stream buffer that only hashes its output, a block at a time):
+
+template <typename CharT, typename Traits>
+class hash_buf: public std::basic_streambuf<CharT, Traits> {
+    CharT block[512];
+    std::uint64_t hash_ = 0;
+
+    void hash_block() noexcept {
+        hash_ = hash_bytes(block, std::size_t(this->pptr() - block) * sizeof(CharT), hash_);
+        this->setp(block, block + std::size(block));
+    }
+
+protected:
+    using int_type = typename Traits::int_type;
+
+    int_type overflow(int_type c) override {
+        hash_block();
+        if (!Traits::eq_int_type(c, Traits::eof()))
+            this->sputc(Traits::to_char_type(c));
+        return Traits::not_eof(c);
+    }
+
+    std::streamsize xsputn(const CharT* s, std::streamsize n) override {
+        for (auto left = n; left;) {
+            if (this->pptr() == this->epptr())
+                hash_block();
+            auto part = std::min(left, std::streamsize(this->epptr() - this->pptr()));
+            Traits::copy(this->pptr(), s, std::size_t(part));
+            this->pbump(int(part));
+            s += part;
+            left -= part;
+        }
+        return n;
+    }
+
+public:
+    hash_buf() noexcept {this->setp(block, block + std::size(block));}
+
+    void clear() noexcept {
+        hash_ = 0;
+        this->setp(block, block + std::size(block));
+    }
+
+    std::uint64_t hash() noexcept { // (of the output since clear())
+        hash_block();
+        return hash_;
+    }
+};
+
+// format_to_n, formatted_size (for delimited_format_to_n() and
+// delimited_formatted_size(); the traversal stops once the stream fails, as
+// it does when the fixed_buf is full):
+
+template <typename CharT, typename Traits, typename Object>
+delimited_format_to_n_result<CharT> format_to_n(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims) {
+    auto fixed = fixed_buf<CharT, Traits>{buf, n};
+    std::basic_ostream<CharT, Traits> out{&fixed};
+    output(obj, delims, delims.top_as_sub, out);
+    return {fixed.end(), std::size_t(fixed.end() - buf), fixed.full()};
+}
+
+template <typename CharT, typename Traits, typename Object>
+std::size_t formatted_size(const Object& obj, const basic_delimiters<CharT, Traits>& delims) {
+    auto counter = size_buf<CharT, Traits>{};
+    std::basic_ostream<CharT, Traits> out{&counter};
+    output(obj, delims, delims.top_as_sub, out);
+    return counter.size();
+}
+
+// realtime_sink (what realtime::delimited_format_to_n() and delimited_static()
+// output to instead of a stream: a character buffer that's filled as far as
+// it goes, with output primitives that don't throw, allocate or use a locale,
+// and that can be used in constant evaluation; it also counts the size of all
+// of the output, which, if it isn't to stop once the buffer is full, is the
+// size of the whole output):
+
+template <typename CharT, typename Traits>
+class realtime_sink {
+    CharT* first;
+    CharT* p;
+    CharT* last;
+    std::size_t size_ = 0;
+    bool stop;
+
+public:
+    constexpr realtime_sink(CharT* buf, std::size_t n, bool stop_when_full = true) noexcept
+        : first{buf}, p{buf}, last{buf + n}, stop{stop_when_full} {}
+
+    constexpr void write(std::basic_string_view<CharT, Traits> str) noexcept {
+        size_ += str.size();
+        auto n = std::min(str.size(), std::size_t(last - p));
+        if (n)
+            Traits::copy(p, str.data(), n);
+        p += n;
+    }
+
+    constexpr CharT* end() const noexcept {return p;}
+    constexpr std::size_t size() const noexcept {return size_;} // (of all of the output, written or not)
+    constexpr bool full() const noexcept {return size_ > std::size_t(last - first);} // (whether output was cut off)
+    constexpr explicit operator bool() const noexcept {return !stop || !full();} // (as a stream's, so emit_elements stops when full)
+};
+
+template <typename T, typename CharT, typename Traits>
+concept realtime_leaf = span_number<T> || std::same_as<T, bool> || std::same_as<T, CharT> || is_string<std::decay_t<T>, CharT, Traits>::value;
+
+// (formats an integer in constant evaluation, where to_chars can't be used
+// before C++23)
+template <std::integral T, typename CharT>
+constexpr CharT* put_integer(CharT* p, T x) noexcept {
+    using magnitude = std::make_unsigned_t<T>;
+    auto m = magnitude(x);
+    if (x < 0) {
+        *p++ = CharT('-');
+        m = magnitude(0) - m;
+    }
+    CharT digits[number_chars<T>] = {};
+    auto d = digits;
+    do
+        *d++ = CharT('0' + m % 10);
+    while (m /= 10);
+    while (d != digits)
+        *p++ = *--d;
+    return p;
+}
+
+template <typename CharT, typename Traits>
+constexpr void put_literal(realtime_sink<CharT, Traits>& out, std::basic_string_view<CharT, Traits> str) noexcept
+{out.write(str);}
+
+template <typename CharT, typename Traits, typename T> requires realtime_leaf<T, CharT, Traits>
+constexpr void put_value(realtime_sink<CharT, Traits>& out, const T& x) noexcept {
+    if constexpr (span_number<T>) {
+        CharT chars[number_chars<T>] = {};
+        CharT* end = nullptr;
+        if constexpr (std::is_integral_v<T>)
+            end = std::is_constant_evaluated() ? put_integer(chars, x) : put_number(chars, x, 6);
+        else
+            end = put_number(chars, x, 6); // (so, not at compile-time)
+        out.write({chars, std::size_t(end - chars)});
+    }
+    else if constexpr (std::same_as<T, bool> || std::same_as<T, CharT>) {
+        CharT c = std::same_as<T, bool> ? CharT(x ? '1' : '0') : CharT(x);
+        out.write({&c, 1});
+    }
+    else
+        out.write(std::basic_string_view<CharT, Traits>(x));
+}
+
+template <typename CharT, typename Traits, typename Object>
+constexpr void output_realtime(const Object& obj, const basic_delimiters<CharT, Traits>& delims, realtime_sink<CharT, Traits>& out) noexcept {
+    if constexpr (plan<Object, CharT, Traits>::may_hold_collection) {
+        if (delims.top_as_sub)
+            emit<true>(obj, delims, out);
+        else
+            emit<false>(obj, delims, out);
+    }
+    else
+        emit<false>(obj, delims, out);
+}
+
+template <typename CharT, typename Traits, typename Object>
+delimited_format_to_n_result<CharT> format_to_n_realtime(CharT* buf, std::size_t n, const Object& obj, const basic_delimiters<CharT, Traits>& delims) noexcept {
+    auto out = realtime_sink<CharT, Traits>{buf, n};
+    output_realtime(obj, delims, out);
+    return {out.end(), std::size_t(out.end() - buf), out.full()};
+}
+
+// make_static (for delimited_static(): formats the object that make_object
+// returns twice, first to count its size and then into the result):
+
+template <typename MakeObject, typename MakeDelims>
+consteval auto make_static() {
+    constexpr auto delims = MakeDelims{}();
+    using delimiters_type = std::remove_cv_t<decltype(delims)>;
+    using char_type = typename delimiters_type::string_view::value_type;
+    using traits_type = typename delimiters_type::string_view::traits_type;
+    constexpr auto size = [&] {
+        auto out = realtime_sink<char_type, traits_type>{nullptr, 0, false};
+        output_realtime(MakeObject{}(), delims, out);
+        return out.size();
+    }();
+    return str_literal<char_type, size + 1>{std::in_place, [&](char_type* p) {
+        auto out = realtime_sink<char_type, traits_type>{p, size};
+        output_realtime(MakeObject{}(), delims, out);
+    }};
+}
+
+// insert (what inserter's stream insertion operator calls; deliberately not
+// inline so that the common instantiations can be compiled once into
+// libdelimited_output.a and declared extern template; see
+// delimited_output_instances.hpp):
+
+template <typename Object, typename CharT, typename Traits>
+std::basic_ostream<CharT, Traits>& insert(std::basic_ostream<CharT, Traits>& out, const Object& obj, const basic_delimiters<CharT, Traits>& delims) {
+    if (delims.atomic)
+        output_atomic(out, obj, delims);
+    else {
+        output(obj, delims, delims.top_as_sub, out);
+        if (!delims.terminator.empty())
+            put_literal(out, delims.terminator);
+    }
+    return out;
+}
+
+template <typename Object, typename CharT, typename Traits> requires (!std::is_const_v<iterable_t<Object>>)
+std::basic_ostream<CharT, Traits>& insert(std::basic_ostream<CharT, Traits>& out, Object& obj, const basic_delimiters<CharT, Traits>& delims) {
+    if (delims.atomic)
+        output_atomic(out, obj, delims);
+    else {
+        output(obj, delims, delims.top_as_sub, out);
+        if (!delims.terminator.empty())
+            put_literal(out, delims.terminator);
+    }
+    return out;
+}
+
+// object_ref (how an inserter refers to the object given to delimited(); by
+// reference, except that rvalue views and other rvalue ranges that can't be
+// iterated as const are moved into it so that the inserter can outlive the
+// expression that created it and iterate them; Object is as deduced by
+// delimited(Object&&)):
+
+template <typename Object>
+class object_ref {
+    using type = std::remove_cvref_t<Object>;
+    using access = iterable_t<std::remove_reference_t<Object>>&;
+
+    static constexpr bool by_value = !std::is_lvalue_reference_v<Object>
+        && (std::ranges::view<type> || !std::is_const_v<iterable_t<type>>);
+
+    static_assert(by_value || std::is_const_v<iterable_t<type>> || !std::is_const_v<std::remove_reference_t<Object>>,
+        "a range that can't be iterated as const (e.g., a filter_view) can't be output via a const reference");
+
+    mutable std::conditional_t<by_value, type, std::remove_reference_t<access>*> obj;
+
+public:
+    object_ref(Object&& obj_) noexcept(!by_value || std::is_nothrow_move_constructible_v<type>)
+        : obj{[&]() -> decltype(auto) {if constexpr (by_value) return std::move(obj_); else return &obj_;}()} {}
+
+    access get() const noexcept {
+        if constexpr (by_value)
+            return obj;
+        else
+            return *obj;
+    }
+};
+
+// inserter:
+
+template <typename Object, typename CharT, typename Traits>
+class inserter {
+    object_ref<Object> obj;
+    basic_delimiters<CharT, Traits> delims;
+public:
+    inserter(Object&& obj_) noexcept(noexcept(object_ref<Object>{std::forward<Object>(obj_)}))
+        : obj{std::forward<Object>(obj_)} {}
+    inserter(Object&& obj_, const basic_delimiters<CharT, Traits>& delims_) noexcept(noexcept(object_ref<Object>{std::forward<Object>(obj_)}))
+        : obj{std::forward<Object>(obj_)}, delims{delims_} {}
+
+    // stream inserter:
+
+    friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& out, const inserter<Object, CharT, Traits>& di)
+    {return insert(out, di.obj.get(), di.delims);}
+
+    // value setters:
+    // Each function return a reference to *this so calls can be chained; e.g.,
+    // cout << delimited(container).delimiter(" - ").empty("Empty")
+
+    using string_view = std::basic_string_view<CharT, Traits>;
+
+    auto& delimiter(string_view str) noexcept // sets top_delim and sub_delim (but not pair_delim)
+    {delims.top_delim = str; delims.sub_delim = str; return *this;}
+
+    auto& top_delim(string_view str) noexcept
+    {delims.top_delim = str; return *this;}
+
+    auto& sub_prefix(string_view str) noexcept
+    {delims.sub_prefix = str; return *this;}
+
+    auto& sub_delim(string_view str) noexcept
+    {delims.sub_delim = str; return *this;}
+
+    auto& sub_suffix(string_view str) noexcept
+    {delims.sub_suffix = str; return *this;}
+
+    auto& pair_prefix(string_view str) noexcept
+    {delims.pair_prefix = str; return *this;}
+
+    auto& pair_delim(string_view str) noexcept
+    {delims.pair_delim = str; return *this;}
+
+    auto& pair_suffix(string_view str) noexcept
+    {delims.pair_suffix = str; return *this;}
+
+    auto& top_as_sub(bool b = true) noexcept
+    {delims.top_as_sub = b; return *this;}
+
+    auto& as_sub(bool b = true) noexcept // concise alternative; e.g.: delimited(arr).as_sub()
+    {delims.top_as_sub = b; return *this;}
+
+    auto& empty(string_view str) noexcept
+    {delims.empty = str; return *this;}
+
+    auto& none(string_view str) noexcept
+    {delims.none = str; return *this;}
+
+    auto& prefetch(std::size_t distance) noexcept
+    {delims.prefetch = distance; return *this;}
+
+    auto& atomic(bool b = true) noexcept
+    {delims.atomic = b; return *this;}
+
+    auto& terminator(string_view str) noexcept // e.g.: delimited(a_map).atomic().terminator("\n")
+    {delims.terminator = str; return *this;}
+
+    auto& table(string_view column_delim, string_view row_delim) noexcept // sets table, column_delim and top_delim
+    {delims.table = true; delims.column_delim = column_delim; delims.top_delim = row_delim; return *this;}
+
+    auto& table() noexcept // e.g.: delimited(rows).table(); sets top_delim to table_row_delim_default
+    {delims.table = true; delims.top_delim = delims.table_row_delim_default.view(); return *this;}
+
+    auto& sorted(std::size_t limit = std::size_t(-1)) noexcept // e.g.: delimited(an_unordered_map).sorted()
+    {delims.sorted = true; delims.sorted_limit = limit; return *this;}
+};
+
+// sequence, sequence_inserter:
+
+template <helpers::iterator Iterator>
+struct sequence {
+    Iterator begin_itr, end_itr;
+    Iterator begin() const {return begin_itr;}
+    Iterator end() const {return end_itr;}
+};
+
+template <iterator Iterator, typename CharT, typename Traits>
+class sequence_inserter: public inserter<sequence<Iterator>&, CharT, Traits> {
+    sequence<Iterator> seq;
+public:
+    sequence_inserter(Iterator begin, Iterator end) noexcept
+        : inserter<sequence<Iterator>&, CharT, Traits>{seq} {seq.begin_itr = begin; seq.end_itr = end;}
+    sequence_inserter(Iterator begin, Iterator end, const basic_delimiters<CharT, Traits>& delims) noexcept
+        : inserter<sequence<Iterator>&, CharT, Traits>{seq, delims} {seq.begin_itr = begin; seq.end_itr = end;}
+};
+
+// chunk_generator (generates the output of an object a chunk at a time; for a
+// range, a chunk is the output of one element and the delimiter before it,
+// except that a table, which needs all of its rows to measure them, is
+// generated as one chunk):
+
+template <typename Object, typename CharT, typename Traits>
+class chunk_generator {
+    enum class stage {prefix, elements, suffix, done};
+
+    using type = std::remove_cvref_t<Object>;
+    using iterable = iterable_t<std::remove_reference_t<Object>>;
+
+    object_ref<Object> obj;
+    basic_delimiters<CharT, Traits> delims;
+    string_buf<CharT, Traits> buf;
+    std::basic_ostream<CharT, Traits> out{&buf};
+    stage stage_ = stage::prefix;
+
+    static constexpr bool range = plan<type, CharT, Traits>::kind == plan_kind::range;
+
+    struct no_cursor {};
+    struct cursor {
+        std::ranges::iterator_t<iterable> itr;
+        std::ranges::sentinel_t<iterable> end;
+    };
+    std::conditional_t<range, std::optional<cursor>, no_cursor> elements;
+
+    bool whole() const noexcept { // (whether the object is output in one chunk)
+        if constexpr (table<iterable, CharT, Traits>) {
+            if (delims.table)
+                return true;
+        }
+        if constexpr (sortable_unordered<std::remove_cv_t<iterable>>) {
+            if (delims.sorted)
+                return true;
+        }
+        return false;
+    }
+
+    void step() {
+        if (!range || whole()) {
+            output(obj.get(), delims, delims.top_as_sub, out);
+            stage_ = stage::done;
+            return;
+        }
+        if constexpr (range) switch (stage_) {
+        case stage::prefix:
+            if (delims.top_as_sub)
+                put_literal(out, delims.sub_prefix);
+            elements.emplace(std::ranges::begin(obj.get()), std::ranges::end(obj.get()));
+            if (elements->itr == elements->end) {
+                put_literal(out, delims.empty);
+                stage_ = stage::suffix;
+            }
+            else {
+                emit<true>(as_iterable(*elements->itr), delims, out);
+                stage_ = ++elements->itr == elements->end ? stage::suffix : stage::elements;
+            }
+            break;
+        case stage::elements:
+            put_literal(out, delims.top_as_sub ? delims.sub_delim : delims.top_delim);
+            emit<true>(as_iterable(*elements->itr), delims, out);
+            if (++elements->itr == elements->end)
+                stage_ = stage::suffix;
+            break;
+        case stage::suffix:
+            if (delims.top_as_sub)
+                put_literal(out, delims.sub_suffix);
+            stage_ = stage::done;
+            break;
+        case stage::done:
+            break;
+        }
+    }
+
+public:
+    chunk_generator(Object&& obj_, const basic_delimiters<CharT, Traits>& delims_)
+        : obj{std::forward<Object>(obj_)}, delims{delims_} {}
+
+    // returns the next chunk, or an empty string view after the last one; the
+    // chunk is valid until the next call
+    std::basic_string_view<CharT, Traits> next() {
+        buf.clear();
+        while (buf.view().empty() && stage_ != stage::done)
+            step();
+        return buf.view();
+    }
+};
+
+// delimited_view (what views::delimited() returns):
+
+template <typename Object, typename CharT, typename Traits>
+class delimited_view: public std::ranges::view_interface<delimited_view<Object, CharT, Traits>> {
+    using generator = chunk_generator<Object, CharT, Traits>;
+    using string_view = std::basic_string_view<CharT, Traits>;
+
+    std::unique_ptr<generator> gen; // heap allocated so the view can be moved
+
+public:
+    class iterator { // input iterator over the characters of the output
+        generator* gen = nullptr;
+        string_view chunk;
+        std::size_t pos = 0;
+    public:
+        using value_type = CharT;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(generator* gen_): gen{gen_}, chunk{gen_->next()} {}
+
+        CharT operator*() const noexcept {return chunk[pos];}
+        iterator& operator++() {
+            if (++pos == chunk.size()) {
+                chunk = gen->next();
+                pos = 0;
+            }
+            return *this;
+        }
+        void operator++(int) {++*this;}
+        friend bool operator==(const iterator& itr, std::default_sentinel_t) noexcept {return itr.chunk.empty();}
+    };
+
+    class chunk_iterator { // input iterator over the chunks of the output
+        generator* gen = nullptr;
+        string_view chunk;
+    public:
+        using value_type = string_view;
+        using difference_type = std::ptrdiff_t;
+
+        chunk_iterator() = default;
+        explicit chunk_iterator(generator* gen_): gen{gen_}, chunk{gen_->next()} {}
+
+        string_view operator*() const noexcept {return chunk;}
+        chunk_iterator& operator++() {chunk = gen->next(); return *this;}
+        void operator++(int) {++*this;}
+        friend bool operator==(const chunk_iterator& itr, std::default_sentinel_t) noexcept {return itr.chunk.empty();}
+    };
+
+    delimited_view(Object&& obj)
+        : gen{std::make_unique<generator>(std::forward<Object>(obj), basic_delimiters<CharT, Traits>{})} {}
+    delimited_view(Object&& obj, const basic_delimiters<CharT, Traits>& delims)
+        : gen{std::make_unique<generator>(std::forward<Object>(obj), delims)} {}
+
+    // like any input range, can only be iterated once (begin() and chunks()
+    // can't both be used)
+    iterator begin() {return iterator{gen.get()};}
+    std::default_sentinel_t end() const noexcept {return {};}
+
+    // (lvalue only, since the view owns the generator the chunks come from)
+    auto chunks() & {return std::ranges::subrange{chunk_iterator{gen.get()}, std::default_sentinel};}
+};
+
+// diff output (see delimited_diff() above):
+
+template <typename T>
+concept sorted_associative = std::ranges::forward_range<const T> && requires(const T& c) {
+    typename T::key_type;
+    c.key_comp();
+};
+
+template <typename T>
+concept byte_comparable_range = std::ranges::contiguous_range<const T> && std::ranges::sized_range<const T>
+    && std::has_unique_object_representations_v<std::ranges::range_value_t<const T>>;
+
+// (outputs one difference; a null element is output as the empty marker)
+template <typename Where, typename A, typename B, typename CharT, typename Traits>
+void put_difference(std::basic_ostream<CharT, Traits>& out, bool& first, const Where& where, const A* a, const B* b, const basic_delimiters<CharT, Traits>& delims) {
+    if (!first)
+        put_literal(out, delims.top_delim);
+    first = false;
+    put_literal(out, delims.sub_prefix);
+    emit<true>(as_iterable(where), delims, out);
+    put_literal(out, delims.sub_delim);
+    if (a)
+        emit<true>(as_iterable(*a), delims, out);
+    else
+        put_literal(out, delims.empty);
+    put_literal(out, delims.sub_delim);
+    if (b)
+        emit<true>(as_iterable(*b), delims, out);
+    else
+        put_literal(out, delims.empty);
+    put_literal(out, delims.sub_suffix);
+}
+
+template <typename Object, typename CharT, typename Traits>
+void output_diff(std::basic_ostream<CharT, Traits>& out, const Object& a, const Object& b, const basic_delimiters<CharT, Traits>& delims) {
+    using kind = plan<Object, CharT, Traits>;
+    static_assert(kind::kind == plan_kind::range || kind::kind == plan_kind::pair || kind::kind == plan_kind::tuple,
+        "delimited_diff() compares ranges, pairs and tuples");
+    bool first = true;
+
+    if constexpr (kind::kind != plan_kind::range) {
+        const auto& fa = as_tuple(a);
+        const auto& fb = as_tuple(b);
+        [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+            ((std::get<Is>(fa) == std::get<Is>(fb) ? void() : put_difference(out, first, Is, &std::get<Is>(fa), &std::get<Is>(fb), delims)), ...);
+        }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<decltype(fa)>>>{});
+    }
+    else if constexpr (sorted_associative<Object>) {
+        // (for maps, the key is first and the mapped value second; for sets,
+        // the element is the key)
+        constexpr bool is_map = requires {typename Object::mapped_type;};
+        auto key = [](const auto& x) -> const auto& {if constexpr (is_map) return x.first; else return x;};
+        auto value = [](const auto& x) {if constexpr (is_map) return &x.second; else return &x;};
+        auto less = a.key_comp();
+        auto ia = std::ranges::begin(a), ea = std::ranges::end(a);
+        auto ib = std::ranges::begin(b), eb = std::ranges::end(b);
+        while (ia != ea || ib != eb) {
+            if (ib == eb || (ia != ea && less(key(*ia), key(*ib)))) {
+                put_difference(out, first, key(*ia), value(*ia), decltype(value(*ia)){}, delims);
+                ++ia;
+            }
+            else if (ia == ea || less(key(*ib), key(*ia))) {
+                put_difference(out, first, key(*ib), decltype(value(*ib)){}, value(*ib), delims);
+                ++ib;
+            }
+            else {
+                if constexpr (is_map)
+                    if (!(ia->second == ib->second))
+                        put_difference(out, first, key(*ia), value(*ia), value(*ib), delims);
+                ++ia;
+                ++ib;
+            }
+        }
+    }
+    else if constexpr (unordered_associative<Object>) {
+        static_assert(!std::same_as<decltype(std::declval<Object&>().insert(std::declval<typename Object::value_type>())), typename Object::iterator>,
+            "delimited_diff() doesn't compare unordered multisets and multimaps");
+        constexpr bool is_map = requires {typename Object::mapped_type;};
+        auto key = [](const auto& x) -> const auto& {if constexpr (is_map) return x.first; else return x;};
+        auto value = [](const auto& x) {if constexpr (is_map) return &x.second; else return &x;};
+        using value_ptr = decltype(value(*std::ranges::begin(a)));
+        for (const auto& x: a) {
+            auto found = b.find(key(x));
+            if (found == b.end())
+                put_difference(out, first, key(x), value(x), value_ptr{}, delims);
+            else if constexpr (is_map)
+                if (!(x.second == found->second))
+                    put_difference(out, first, key(x), value(x), value(*found), delims);
+        }
+        for (const auto& x: b)
+            if (!a.contains(key(x)))
+                put_difference(out, first, key(x), value_ptr{}, value(x), delims);
+    }
+    else {
+        using element = std::remove_reference_t<std::ranges::range_reference_t<const Object>>;
+        std::size_t index = 0;
+        auto ia = std::ranges::begin(a), ea = std::ranges::end(a);
+        auto ib = std::ranges::begin(b), eb = std::ranges::end(b);
+        if constexpr (byte_comparable_range<Object>) {
+            // (skips whole blocks that are identical)
+            constexpr std::size_t block = 64;
+            auto size = std::min(std::ranges::size(a), std::ranges::size(b));
+            auto pa = std::ranges::data(a), pb = std::ranges::data(b);
+            for (; index < size; index += block) {
+                auto n = std::min(block, size - index);
+                if (std::memcmp(pa + index, pb + index, n * sizeof(element)) == 0)
+                    continue;
+                for (auto i = index; i < index + n; ++i)
+                    if (!(pa[i] == pb[i]))
+                        put_difference(out, first, i, pa + i, pb + i, delims);
+            }
+            index = size;
+            ia += size;
+            ib += size;
+        }
+        for (; ia != ea && ib != eb; ++ia, ++ib, ++index)
+            if (!(*ia == *ib))
+                put_difference(out, first, index, &*ia, &*ib, delims);
+        for (; ia != ea; ++ia, ++index)
+            put_difference(out, first, index, &*ia, static_cast<const element*>(nullptr), delims);
+        for (; ib != eb; ++ib, ++index)
+            put_difference(out, first, index, static_cast<const element*>(nullptr), &*ib, delims);
+    }
+
+    if (first)
+        put_literal(out, delims.empty);
+}
+
+// output_if_changed (for delimited_if_changed()):
+
+template <typename CharT, typename Traits, typename Object>
+bool output_if_changed(delimited_last_output& last, std::basic_ostream<CharT, Traits>& out, const Object& obj, const basic_delimiters<CharT, Traits>& delims) {
+    if constexpr (byte_comparable_range<Object>) {
+        if (!last.update(hash_bytes(std::ranges::data(obj), std::ranges::size(obj) * sizeof *std::ranges::data(obj))))
+            return false;
+        insert(out, obj, delims);
+    }
+    else {
+        // (the output is hashed as it's formatted, without being kept, and
+        // formatted again if it's changed)
+        static thread_local scratch_stream<CharT, Traits, hash_buf<CharT, Traits>> hashing;
+        if (&out == &hashing.out) { // (output while hashing; not tracked)
+            insert(out, obj, delims);
+            return true;
+        }
+        hashing.start(out);
+        output(obj, delims, delims.top_as_sub, hashing.out);
+        if (!last.update(hashing.buf.hash()))
+            return false;
+        insert(out, obj, delims);
+    }
+    return true;
+}
+
+// stored_delimiters (a copy of a delimiters object that owns its strings):
+
+template <typename CharT, typename Traits>
+class stored_delimiters {
+    using delimiters_type = basic_delimiters<CharT, Traits>;
+
+    static constexpr std::basic_string_view<CharT, Traits> delimiters_type::* strings[] = {
+        &delimiters_type::top_delim, &delimiters_type::sub_prefix, &delimiters_type::sub_delim, &delimiters_type::sub_suffix,
+        &delimiters_type::pair_prefix, &delimiters_type::pair_delim, &delimiters_type::pair_suffix, &delimiters_type::empty,
+        &delimiters_type::none, &delimiters_type::column_delim, &delimiters_type::terminator};
+
+    std::basic_string<CharT, Traits> text; // (the strings, concatenated)
+    delimiters_type delims; // (with its strings in text)
+
+public:
+    const delimiters_type& get() const noexcept {return delims;}
+
+    // (compares what affects the output)
+    bool operator==(const delimiters_type& other) const noexcept {
+        for (auto str: strings)
+            if (delims.*str != other.*str)
+                return false;
+        return delims.top_as_sub == other.top_as_sub && delims.table == other.table
+            && delims.sorted == other.sorted && delims.sorted_limit == other.sorted_limit;
+    }
+
+    stored_delimiters& operator=(const delimiters_type& other) {
+        delims = other;
+        text.clear();
+        for (auto str: strings)
+            text += other.*str;
+        std::size_t pos = 0;
+        for (auto str: strings) {
+            delims.*str = std::basic_string_view<CharT, Traits>{text}.substr(pos, (other.*str).size());
+            pos += (other.*str).size();
+        }
+        return *this;
+    }
+};
+
+} // namespace helpers
+
+// basic_delimited_cache (see cached_delimited() above):
+
+template <typename CharT, typename Traits>
+class basic_delimited_cache {
+    struct entry {
+        std::uint64_t version = 0;
+        helpers::stored_delimiters<CharT, Traits> delims;
+        std::ios_base::fmtflags flags{};
+        std::streamsize precision = 0;
+        std::streamsize width = 0;
+        CharT fill{};
+        std::basic_string<CharT, Traits> text;
+    };
+
+    // (keyed on the object's address and a tag for its type, so that, e.g., a
+    // struct and its first member don't share an entry)
+    std::map<std::pair<const void*, const void*>, entry> entries;
+
+    template <typename Object>
+    static const void* type_tag() noexcept {
+        static const char tag = 0;
+        return &tag;
+    }
+
+public:
+    template <typename Object>
+    void output(std::basic_ostream<CharT, Traits>& out, const Object& obj, std::uint64_t version, const basic_delimiters<CharT, Traits>& delims) {
+        auto [itr, added] = entries.try_emplace({std::addressof(obj), type_tag<Object>()});
+        auto& e = itr->second;
+        if (added || e.version != version || !(e.delims == delims) || e.flags != out.flags()
+            || e.precision != out.precision() || e.width != out.width() || e.fill != out.fill()) {
+            auto formatted = helpers::scratch_stream<CharT, Traits>{}; // (not the thread's, which out may be)
+            formatted.start(out);
+            helpers::output(obj, delims, delims.top_as_sub, formatted.out);
+            helpers::put_literal(formatted.out, delims.terminator);
+            e.text = std::move(formatted.buf.str());
+            e.version = version;
+            e.delims = delims;
+            e.flags = out.flags();
+            e.precision = out.precision();
+            e.width = out.width();
+            e.fill = out.fill();
+        }
+        out.width(0);
+        helpers::put_text(out, std::basic_string_view<CharT, Traits>{e.text});
+    }
+
+    void clear() noexcept {entries.clear();}
+    std::size_t size() const noexcept {return entries.size();}
+};
+
+// basic_delimited_appender (see above):
+
+template <typename CharT, typename Traits>
+class basic_delimited_appender {
+    helpers::stored_delimiters<CharT, Traits> delims;
+    std::size_t emitted = 0;
+
+    template <typename Range>
+    class inserter {
+        basic_delimited_appender& appender;
+        const Range& range;
+    public:
+        inserter(basic_delimited_appender& appender_, const Range& range_) noexcept
+            : appender{appender_}, range{range_} {}
+
+        void output(std::basic_ostream<CharT, Traits>& out) const {appender.output(out, range);}
+
+        friend std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& out, const inserter& ai)
+        {ai.output(out); return out;}
+    };
+
+    template <typename Range>
+    void output(std::basic_ostream<CharT, Traits>& out, const Range& range) {
+        const auto& delims = this->delims.get();
+        auto itr = std::ranges::begin(range);
+        auto end = std::ranges::end(range);
+        if constexpr (std::ranges::random_access_range<const Range> && std::ranges::sized_range<const Range>) {
+            assert(emitted <= std::size_t(std::ranges::size(range)) && "range shrank; see reset()");
+            itr += std::min(emitted, std::size_t(std::ranges::size(range)));
+        }
+        else
+            for (auto n = emitted; n && itr != end; --n)
+                ++itr;
+        for (; itr != end; ++itr) {
+            if (emitted++)
+                helpers::put_literal(out, delims.top_delim);
+            helpers::emit<true>(helpers::as_iterable(*itr), delims, out);
+        }
+    }
+
+public:
+    basic_delimited_appender() {delims = basic_delimiters<CharT, Traits>{};}
+    explicit basic_delimited_appender(const basic_delimiters<CharT, Traits>& delims_) {delims = delims_;}
+
+    // returns a helper object whose stream insertion operator outputs the
+    // elements of range added since the last time
+    template <std::ranges::forward_range Range>
+    inserter<Range> operator()(const Range& range) noexcept {return {*this, range};}
+
+    std::size_t count() const noexcept {return emitted;} // of the elements output so far
+    void reset() noexcept {emitted = 0;}
+};
+
+// basic_delimited_formatter (see above):
+
+template <typename T, typename CharT, typename Traits>
+class basic_delimited_formatter {
+    helpers::stored_delimiters<CharT, Traits> delims;
+    helpers::string_buf<CharT, Traits> buf;
+    std::basic_ostream<CharT, Traits> out{&buf};
+
+public:
+    basic_delimited_formatter() {delims = basic_delimiters<CharT, Traits>{};}
+    explicit basic_delimited_formatter(const basic_delimiters<CharT, Traits>& delims_) {delims = delims_;}
+
+    std::basic_string_view<CharT, Traits> format(const T& x) {
+        buf.clear();
+        out.clear();
+        const auto& delims = this->delims.get();
+        helpers::output(x, delims, delims.top_as_sub, out);
+        return buf.view();
+    }
+
+    std::basic_ostream<CharT, Traits>& stream() noexcept {return out;}
+};
+
+} // namespace delimited_output
+
+#ifdef DELIMITED_OUTPUT_EXTERN_TEMPLATES
+#include "delimited_output_instances.hpp"
+#endif
 
 #endif // DELIMITED_OUTPUT_HPP
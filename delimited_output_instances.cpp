@@ -0,0 +1,7 @@
+// explicit instantiation definitions of the common instantiations listed in
+// delimited_output_instances.hpp; compiled into libdelimited_output.a.
+
+#define DELIMITED_OUTPUT_DEFINE_INSTANCES
+#include "delimited_output_instances.hpp"
+
+DELIMITED_OUTPUT_INSTANCES(DELIMITED_OUTPUT_INSERT_INSTANCE)
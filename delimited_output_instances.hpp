@@ -0,0 +1,62 @@
+#ifndef DELIMITED_OUTPUT_INSTANCES_HPP
+#define DELIMITED_OUTPUT_INSTANCES_HPP
+
+// common instantiations of delimited_output::helpers::insert, which are
+// compiled once into libdelimited_output.a (see delimited_output_instances.cpp
+// and the lib target in the Makefile).
+//
+// defining DELIMITED_OUTPUT_EXTERN_TEMPLATES before including
+// delimited_output.hpp includes this header, which declares them extern
+// template so that translation units outputting, e.g., a vector<int> or a
+// map<string, string> don't instantiate the whole output template tree for it
+// again; such programs must then be linked with libdelimited_output.a.
+//
+// the instantiations are for char and wchar_t streams (with default char
+// traits) and, with V being each of int, long, double, string and string_view
+// (or wstring and wstring_view for wchar_t), for:
+//     vector<V>
+//     map<K, V>, pair<K, V> and tuple<K, V>, with K being int, long or string
+// (std::array isn't included since its extent is part of its type.)
+
+#include "delimited_output.hpp"
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <string>
+#include <string_view>
+
+#define DELIMITED_OUTPUT_INSTANCES_FOR_KEY(X, CharT, K, V) \
+    X(CharT, std::map<K, V>) \
+    X(CharT, std::pair<K, V>) \
+    X(CharT, std::tuple<K, V>)
+
+#define DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, V) \
+    X(CharT, std::vector<V>) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_KEY(X, CharT, int, V) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_KEY(X, CharT, long, V) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_KEY(X, CharT, std::basic_string<CharT>, V)
+
+#define DELIMITED_OUTPUT_INSTANCES_FOR_CHAR(X, CharT) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, int) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, long) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, double) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, std::basic_string<CharT>) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_VALUE(X, CharT, std::basic_string_view<CharT>)
+
+// X(CharT, Object) is expanded for each instantiation
+#define DELIMITED_OUTPUT_INSTANCES(X) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_CHAR(X, char) \
+    DELIMITED_OUTPUT_INSTANCES_FOR_CHAR(X, wchar_t)
+
+#define DELIMITED_OUTPUT_INSERT_INSTANCE(CharT, ...) \
+    template std::basic_ostream<CharT>& delimited_output::helpers::insert<__VA_ARGS__, CharT, std::char_traits<CharT>>( \
+        std::basic_ostream<CharT>&, const __VA_ARGS__&, const delimited_output::basic_delimiters<CharT>&);
+
+#ifndef DELIMITED_OUTPUT_DEFINE_INSTANCES
+#define DELIMITED_OUTPUT_EXTERN_INSERT_INSTANCE(CharT, ...) extern DELIMITED_OUTPUT_INSERT_INSTANCE(CharT, __VA_ARGS__)
+DELIMITED_OUTPUT_INSTANCES(DELIMITED_OUTPUT_EXTERN_INSERT_INSTANCE)
+#undef DELIMITED_OUTPUT_EXTERN_INSERT_INSTANCE
+#endif
+
+#endif // DELIMITED_OUTPUT_INSTANCES_HPP
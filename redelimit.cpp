@@ -0,0 +1,161 @@
+// redelimit: reads records of delimited fields from stdin and writes them to
+// stdout with other delimiters; for example, converts lines output by
+// delimited() for vectors of strings ("a, b, <empty>") to tab-separated lines.
+// Input is read and output is written in large blocks, and only the record
+// being converted is held in memory (plus the unread part of the current
+// block), so memory use is bounded by the block size or the longest record.
+//
+// usage: redelimit [option value]...
+//    -d  input field delimiter (default ", ")
+//    -e  input empty field marker (default "<empty>")
+//    -r  input record delimiter (default "\n")
+//    -D  output field delimiter (default "\t")
+//    -E  output empty field marker (default "")
+//    -R  output record delimiter (default "\n")
+// Values may contain the escapes \t, \n, \r and \\.
+// A record terminated by the input record delimiter is output terminated by
+// the output record delimiter; a final unterminated record is output
+// unterminated.
+
+#include "delimited_output.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace delimited_output;
+
+constexpr std::size_t block_size = 1 << 20;
+
+// a delimiter profile for one side of the conversion; delims.top_delim
+// separates fields and delims.empty marks an empty field
+struct profile {
+    delimiters delims;
+    std::string_view record_delim;
+};
+
+std::string unescape(std::string_view arg) {
+    auto str = std::string{};
+    for (std::size_t i = 0; i < arg.size(); ++i) {
+        if (arg[i] != '\\' || i + 1 == arg.size()) {
+            str += arg[i];
+            continue;
+        }
+        switch (arg[++i]) {
+        case 't': str += '\t'; break;
+        case 'n': str += '\n'; break;
+        case 'r': str += '\r'; break;
+        default: str += arg[i]; break;
+        }
+    }
+    return str;
+}
+
+// splits records into fields and outputs them via delimited()
+class converter {
+    const profile& in;
+    const profile& out;
+    std::ostream& os;
+    std::vector<std::string_view> fields; // reused so records don't allocate
+
+public:
+    converter(const profile& in_, const profile& out_, std::ostream& os_)
+        : in{in_}, out{out_}, os{os_} {}
+
+    void convert(std::string_view record, bool terminated) {
+        fields.clear();
+        for (auto pos = std::size_t{0};;) {
+            auto end = in.delims.top_delim.empty() ? std::string_view::npos : record.find(in.delims.top_delim, pos);
+            auto field = record.substr(pos, end - pos);
+            fields.push_back(field == in.delims.empty ? std::string_view{} : field);
+            if (end == std::string_view::npos)
+                break;
+            pos = end + in.delims.top_delim.size();
+        }
+        os << delimited(fields, out.delims);
+        if (terminated)
+            os << out.record_delim;
+    }
+};
+
+// reads stdin a block at a time and passes each complete record to the
+// converter; a record longer than a block grows the buffer to fit it
+bool redelimit(const profile& in, converter& conv) {
+    auto buf = std::vector<char>(block_size);
+    auto delim = in.record_delim;
+    std::size_t size = 0; // of the data in buf (an incomplete record)
+    std::size_t scanned = 0; // of that data, the part known not to contain a delimiter
+    for (;;) {
+        if (size == buf.size())
+            buf.resize(buf.size() * 2);
+        auto n = std::fread(buf.data() + size, 1, buf.size() - size, stdin);
+        if (n == 0)
+            break;
+        size += n;
+
+        auto data = std::string_view{buf.data(), size};
+        std::size_t start = 0;
+        for (auto end = data.find(delim, scanned); end != std::string_view::npos; end = data.find(delim, start)) {
+            conv.convert(data.substr(start, end - start), true);
+            start = end + delim.size();
+        }
+        size -= start;
+        std::memmove(buf.data(), buf.data() + start, size);
+        scanned = size < delim.size() ? 0 : size - delim.size() + 1;
+    }
+    if (size)
+        conv.convert({buf.data(), size}, false);
+    return !std::ferror(stdin);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto in = profile{delimiters{}, "\n"};
+    auto out = profile{delimiters{}, "\n"};
+    out.delims.top_delim = "\t";
+    out.delims.empty = "";
+
+    auto args = std::vector<std::string>{}; // storage for the unescaped values
+    args.reserve(argc);
+    for (int i = 1; i < argc; i += 2) {
+        auto option = std::string_view{argv[i]};
+        if (i + 1 == argc || option.size() != 2 || option[0] != '-') {
+            std::cerr << "usage: redelimit [-d|-e|-r|-D|-E|-R value]...\n";
+            return 2;
+        }
+        auto value = std::string_view{args.emplace_back(unescape(argv[i + 1]))};
+        switch (option[1]) {
+        case 'd': in.delims.top_delim = value; break;
+        case 'e': in.delims.empty = value; break;
+        case 'r': in.record_delim = value; break;
+        case 'D': out.delims.top_delim = value; break;
+        case 'E': out.delims.empty = value; break;
+        case 'R': out.record_delim = value; break;
+        default:
+            std::cerr << "redelimit: unknown option " << option << '\n';
+            return 2;
+        }
+    }
+    if (in.record_delim.empty()) {
+        std::cerr << "redelimit: the input record delimiter can't be empty\n";
+        return 2;
+    }
+
+    std::ios::sync_with_stdio(false);
+    static auto out_buf = std::vector<char>(block_size); // (outlives cout's use of it)
+    std::cout.rdbuf()->pubsetbuf(out_buf.data(), out_buf.size());
+
+    auto conv = converter{in, out, std::cout};
+    auto ok = redelimit(in, conv);
+    std::cout.flush();
+    if (!ok || !std::cout) {
+        std::cerr << "redelimit: I/O error\n";
+        return 1;
+    }
+}
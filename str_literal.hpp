@@ -3,6 +3,11 @@
 
 #include <utility>
 #include <string>
+#ifdef __cpp_exceptions
+#include <stdexcept>
+#else
+#include <cstdlib>
+#endif
 
 // struct and function for converting a c-style string literal to a c-style
 // string literal of a parameterized character type at compile-time. (see usage
@@ -13,6 +18,12 @@
 
 namespace delimited_output::helpers {
 
+#ifndef __cpp_exceptions
+// (what str_literal does instead of throwing when exceptions are disabled;
+// not constexpr, so calling it at compile-time is an error, as throwing is)
+[[noreturn]] inline void str_literal_error(const char*) noexcept {std::abort();}
+#endif
+
 template <typename CharT, std::size_t Capacity>
 class str_literal {
     CharT data_[Capacity]; // includes space for null-terminator
@@ -30,6 +41,13 @@ public:
     constexpr std::basic_string_view<CharT, Traits> view() const noexcept {return {data_, size()};}
     // extend as needed
 
+    // (from the characters that fill writes to the CharT* it's given, size() of
+    // them; e.g., for text formatted at compile-time)
+    template <typename Fill>
+    constexpr str_literal(std::in_place_t, Fill fill): data_{} {
+        fill(data_);
+    }
+
     template <typename SrcCharT>
     constexpr str_literal(SrcCharT(&src)[Capacity]) {
         auto p_data = data_;
@@ -37,9 +55,17 @@ public:
             if (c < 0 || c > 127)
                 // assume unicode encoding; restrict source characters to common
                 // ASCII subset so they can simply be copied
+#ifdef __cpp_exceptions
                 throw std::out_of_range("Value in ASCII range (0...127) was expected");
+#else
+                str_literal_error("Value in ASCII range (0...127) was expected");
+#endif
             if (p_data == end() && c != 0)
+#ifdef __cpp_exceptions
                 throw std::invalid_argument("Null-terminated string was expected");
+#else
+                str_literal_error("Null-terminated string was expected");
+#endif
             *p_data++ = c;
         }
     }
@@ -3,15 +3,74 @@
 // program; see: http://gcc.gnu.org/ml/gcc-bugs/2006-05/msg01196.html)
 
 #include "delimited_output.hpp"
+#include "delimited_async.hpp"
 
 #include <iostream>
 #include <algorithm>
 #include <vector>
 #include <array>
+#include <span>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <list>
+#include <deque>
+#include <iomanip>
+#include <iterator>
 #include <tuple>
+#include <optional>
+#include <variant>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <string_view>
+
+namespace {
+
+// (output field by field)
+struct point {
+    int x;
+    int y;
+};
+
+struct order {
+    std::string item;
+    point where;
+    std::vector<int> quantities;
+};
+
+// (output via its stream insertion operator, not field by field)
+struct labeled {
+    int value;
+    bool operator==(const labeled&) const = default; // (and hashable, but no <)
+};
+
+std::ostream& operator<<(std::ostream& out, const labeled& l) {
+    return out << "#" << l.value;
+}
+
+// (tuple-like, via tuple_size and get)
+class range_bounds {
+    int low_, high_;
+public:
+    range_bounds(int low, int high): low_{low}, high_{high} {}
+    template <std::size_t I> int get() const {return I == 0 ? low_ : high_;}
+};
+
+template <std::size_t I>
+int get(const range_bounds& r) {
+    return r.get<I>();
+}
+
+}
+
+template <> struct std::hash<labeled> {
+    std::size_t operator()(const labeled& l) const noexcept {return std::hash<int>{}(l.value);}
+};
+
+template <> struct std::tuple_size<range_bounds>: std::integral_constant<std::size_t, 2> {};
+template <std::size_t I> struct std::tuple_element<I, range_bounds> {using type = int;};
 
 int main() {
     using namespace std;
@@ -138,4 +197,393 @@ int main() {
         };
         cout << delimited(seasons).top_delim("\n") << endl;
     }
+    {
+        cout << endl;
+        auto a_map = map<int, const char*>{{1, "One"}, {2, "Two"}, {4, "Four"}};
+        cout << delimited(a_map).prefetch(2) << endl;
+        auto a_list = list{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        cout << delimited(a_list).prefetch(4).as_sub() << endl;
+        cout << delimited(list<int>{}).prefetch(4) << endl;
+        auto tested = 0;
+        auto odd = a_list | std::views::filter([&](int i) {++tested; return i % 2;});
+        cout << delimited(odd).prefetch(4) << ' ' << tested << endl; // (a view isn't prefetched)
+    }
+    {
+        cout << endl;
+        auto doubles = vector{1.5, -2.25, 1e20, 3.14159265, 0.0};
+        cout << delimited(doubles) << endl;
+        cout << setprecision(3) << delimited(doubles) << setprecision(6) << endl;
+        cout << fixed << delimited(doubles) << defaultfloat << endl;
+        cout << showpos << delimited(array{1, -2, 3}) << noshowpos << endl;
+        cout << setw(4) << delimited(array{1, -2, 3}) << endl;
+        auto ints = deque<int>{};
+        auto strs = deque<string>{};
+        for (int i = 0; i < 1000; ++i) {
+            ints.push_front(i);
+            strs.push_back(i % 7 ? to_string(i) : string{});
+        }
+        stringstream ss1, ss2;
+        ss1 << delimited(ints) << delimited(strs);
+        ss2 << delimited(vector(ints.begin(), ints.end())) << delimited(vector(strs.begin(), strs.end()));
+        cout << (ss1.str() == ss2.str() ? "deque output matches vector output" : "deque output differs from vector output") << endl;
+        cout << delimited(deque(ints.begin() + 990, ints.end())).as_sub() << endl;
+    }
+    {
+        cout << endl;
+        auto vectors = vector<vector<int>>{{1, 2, 3}, {}, {4, 5}};
+        ranges::copy(delimited_output::views::delimited(vectors), ostreambuf_iterator<char>(cout));
+        cout << endl;
+        auto a_map = map<int, string>{{1, "One"}, {2, "Two"}, {3, "Three"}};
+        auto delims = delimiters{};
+        delims.top_as_sub = true;
+        auto view = delimited_output::views::delimited(a_map, delims);
+        for (auto chunk: view.chunks())
+            cout << '<' << chunk << '>';
+        cout << endl;
+        cout << ranges::count(delimited_output::views::delimited(vectors), ',') << endl;
+    }
+    {
+        cout << endl;
+        auto ints = vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        auto is_odd = [](int i) {return i % 2 != 0;};
+        cout << delimited(ints | std::views::filter(is_odd)) << endl;
+        auto evens = ints | std::views::filter([](int i) {return i % 2 == 0;});
+        cout << delimited(evens).as_sub() << endl;
+        auto rows = vector<vector<int>>{{1, 2, 3}, {4, 5}, {6}};
+        cout << delimited(rows | std::views::transform([&](const vector<int>& row) {return row | std::views::filter(is_odd);})) << endl;
+        auto in = istringstream{"10 20 30"};
+        cout << delimited(std::views::istream<int>(in)).delimiter(" + ") << endl;
+        ranges::copy(delimited_output::views::delimited(ints | std::views::filter(is_odd)), ostreambuf_iterator<char>(cout));
+        cout << endl;
+    }
+    {
+        cout << endl;
+        {
+            auto sink = async_sink{cout};
+            sink.write(vector<int>{1, 2, 3});
+            sink.write(map<int, string>{{1, "One"}, {2, ""}});
+            sink.write(list<pair<string, vector<double>>>{{"a", {1.5, 2}}, {"b", {}}});
+            auto delims = delimiters{};
+            delims.top_delim = " | ";
+            sink.write(tuple{1, "Two", '3'}, delims);
+            sink.flush();
+            sink.write(deque<int>{});
+        }
+        auto out = stringstream{};
+        {
+            auto sink = async_sink{out, 4096};
+            auto threads = vector<thread>{};
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&sink, t] {
+                    for (int i = 0; i < 1000; ++i)
+                        sink.write(vector<int>(i % 20, t));
+                });
+            for (auto& th: threads)
+                th.join();
+        }
+        int records = 0, torn = 0;
+        for (string line; getline(out, line); ++records) {
+            auto t = line.empty() ? '?' : line[0];
+            torn += line != "<empty>" && line.find_first_not_of(string{t, ',', ' '}) != string::npos;
+        }
+        cout << records << " records, " << torn << " torn" << endl;
+        auto wrapped = stringstream{};
+        {
+            auto sink = async_sink{wrapped, 4096}; // (records of over half the ring buffer, which wrap)
+            for (int i = 0; i < 6; ++i) {
+                sink.write(vector<int>(i % 2 ? 700 : 400, i));
+                if (i == 0)
+                    sink.flush();
+            }
+        }
+        records = 0;
+        std::size_t values = 0;
+        for (string line; getline(wrapped, line); ++records)
+            values += ranges::count(line, ',') + 1;
+        cout << records << " wrapped records, " << values << " values" << endl;
+    }
+    {
+        cout << endl;
+        {
+            auto sink = shared_sink{cout};
+            sink.write(vector<int>{1, 2, 3});
+            sink.write(delimited(map<int, string>{{1, "One"}, {2, "Two"}}).pair_delim("=").as_sub());
+            sink.flush();
+            sink.write(list<double>{});
+        }
+        auto out = stringstream{};
+        {
+            auto sink = shared_sink{out, 4096};
+            auto threads = vector<thread>{};
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&sink, t] {
+                    for (int i = 0; i < 1000; ++i)
+                        sink.write(vector<int>(i % 20, t));
+                });
+            for (auto& th: threads)
+                th.join();
+        }
+        int records = 0, torn = 0;
+        for (string line; getline(out, line); ++records) {
+            auto t = line.empty() ? '?' : line[0];
+            torn += line != "<empty>" && line.find_first_not_of(string{t, ',', ' '}) != string::npos;
+        }
+        cout << records << " records, " << torn << " torn" << endl;
+    }
+    {
+        cout << endl;
+        auto a_map = map<int, string>{{1, "One"}, {2, "Two"}, {3, ""}};
+        cout << delimited(a_map).atomic().terminator("\n");
+        cout << delimited(a_map).terminator(" (not atomic)\n");
+        auto doubles = vector<double>{1.23456, 2.5, 1e-7};
+        stringstream ss1, ss2;
+        ss1 << setprecision(3) << showpos << setw(8) << left << setfill('*') << delimited(doubles) << '|';
+        ss2 << setprecision(3) << showpos << setw(8) << left << setfill('*') << delimited(doubles).atomic() << '|';
+        cout << ss1.str() << endl << (ss1.str() == ss2.str() ? "atomic output matches" : "atomic output differs") << endl;
+        struct counting_buf: streambuf {
+            int writes = 0;
+            int_type overflow(int_type c) override {++writes; return c;}
+            streamsize xsputn(const char*, streamsize n) override {++writes; return n;}
+        } buf;
+        ostream out{&buf};
+        out << delimited(a_map);
+        auto writes = buf.writes;
+        buf.writes = 0;
+        out << delimited(a_map).atomic().terminator("\n");
+        cout << writes << " writes, " << buf.writes << " atomic" << endl;
+#ifdef DELIMITED_OUTPUT_HAS_WRITE_FD
+        int fds[2];
+        if (pipe(fds) == 0) {
+            delimited_write(fds[1], a_map, delimiters{}, ";\n");
+            close(fds[1]);
+            char text[64];
+            auto n = read(fds[0], text, sizeof text);
+            close(fds[0]);
+            cout << string_view(text, n > 0 ? n : 0);
+        }
+#endif
+    }
+    {
+        cout << endl;
+        auto ages = map<string, int>{{"Alice", 30}, {"Bob", 4}, {"Carol", 120}};
+        cout << delimited(ages).table() << endl;
+        cout << right << delimited(ages).table(" | ", "\n") << left << endl;
+        auto rows = vector<tuple<int, string, vector<int>>>{{1, "One", {1}}, {22, "", {}}, {333, "Three", {1, 2, 3}}};
+        cout << delimited(rows).table() << endl;
+        auto ragged = vector<vector<double>>{{1.5, 2}, {}, {3, 4.25, 5}};
+        cout << delimited(ragged).table() << endl;
+        cout << delimited(vector<vector<int>>{}).table() << endl;
+        cout << delimited(vector<vector<int>>{{}, {}}).table() << endl;
+        cout << delimited(vector<tuple<>>(2)).table() << endl;
+        auto table_delims = delimiters{};
+        table_delims.table = true;
+        table_delims.top_delim = table_delims.table_row_delim_default.view();
+        ranges::copy(delimited_output::views::delimited(ages, table_delims), ostreambuf_iterator<char>(cout));
+        cout << endl;
+    }
+    {
+        cout << endl;
+        auto cache = delimited_cache{};
+        auto config = map<string, int>{{"retries", 3}, {"timeout", 30}};
+        std::uint64_t version = 1;
+        cout << cached_delimited(cache, config, version) << endl;
+        config["timeout"] = 60; // (not output, as the version is unchanged)
+        cout << cached_delimited(cache, config, version) << endl;
+        ++version;
+        cout << cached_delimited(cache, config, version) << endl;
+        auto delims = delimiters{};
+        delims.top_delim = "; ";
+        cout << cached_delimited(cache, config, version, delims) << endl;
+        delims.terminator = " (terminated)\n";
+        cout << cached_delimited(cache, config, version, delims);
+        cout << cached_delimited(cache, config, version, delims); // (from the cache, with the terminator)
+        cout << setw(10) << cached_delimited(cache, config.begin()->first, 0) << '|' << endl;
+        cout << cached_delimited(cache, config.begin()->first, 0) << '|' << endl;
+        cout << cache.size() << " cached" << endl;
+    }
+    {
+        cout << endl;
+        auto events = vector<pair<int, string>>{};
+        auto appender = delimited_appender{};
+        stringstream appended;
+        for (int tick = 0; tick < 4; ++tick) {
+            for (int i = 0; i < tick; ++i)
+                events.emplace_back(tick, i % 2 ? "odd" : "");
+            auto chunk = stringstream{};
+            chunk << appender(events);
+            cout << '<' << chunk.str() << '>';
+            appended << chunk.str();
+        }
+        cout << endl << appender.count() << endl;
+        stringstream full;
+        full << delimited(events);
+        cout << (appended.str() == full.str() ? "appended output matches" : "appended output differs") << endl;
+        auto delims = delimiters{};
+        delims.top_delim = " / ";
+        auto list_appender = delimited_appender{delims};
+        auto a_list = list<vector<int>>{{1, 2}};
+        cout << list_appender(a_list);
+        a_list.push_back({});
+        a_list.push_back({3});
+        cout << list_appender(a_list) << endl;
+    }
+    {
+        cout << endl;
+        cout << delimited_diff(vector<int>{1, 2, 3}, vector<int>{1, 5}) << endl;
+        cout << delimited_diff(map<int, string>{{1, "a"}, {2, "b"}}, map<int, string>{{2, "c"}, {3, "d"}}) << endl;
+        cout << delimited_diff(set<int>{1, 3, 5, 7}, set<int>{1, 4, 5}) << endl;
+        cout << delimited_diff(list<string>{"x", "y"}, list<string>{"x", "z", "w"}) << endl;
+        cout << delimited_diff(make_tuple(1, string{"same"}, 2.5), make_tuple(1, string{"other"}, 2.5)) << endl;
+        auto before = vector<int>(1000);
+        for (int i = 0; i < 1000; ++i)
+            before[i] = i;
+        auto after = before;
+        after[700] = -1;
+        after.push_back(1000);
+        cout << delimited_diff(before, after) << endl;
+        cout << delimited_diff(before, before) << endl;
+        auto delims = delimiters{};
+        delims.top_delim = "; ";
+        delims.sub_prefix = "";
+        delims.sub_delim = " ";
+        delims.sub_suffix = "";
+        cout << delimited_diff(vector<vector<int>>{{1}, {2, 3}}, vector<vector<int>>{{1}, {2}}, delims) << endl;
+        auto buckets = unordered_set<int>{}; // (equal, but iterated in different orders)
+        buckets.rehash(1000);
+        for (int i = 0; i < 12; ++i)
+            buckets.insert(i * 37);
+        cout << delimited_diff(unordered_set<int>(buckets.begin(), buckets.end()), buckets) << endl;
+        cout << delimited_diff(unordered_map<int, int>{{1, 1}, {2, 2}}, unordered_map<int, int>{{2, 2}, {1, 1}}) << endl;
+        cout << delimited_diff(unordered_map<int, string>{{1, "a"}, {2, "b"}}, unordered_map<int, string>{{2, "c"}, {3, "d"}}) << endl;
+    }
+    {
+        cout << endl;
+        auto names = unordered_map<string, int>{{"Carol", 3}, {"Alice", 1}, {"Bob", 2}, {"Dave", 4}};
+        cout << delimited(names).sorted() << endl;
+        ranges::copy(delimited_output::views::delimited(names, delimiters{.sorted = true}), ostreambuf_iterator<char>(cout));
+        cout << endl;
+        auto unsortable = unordered_set<labeled>{{7}}; // (no <, so output in hash order)
+        cout << delimited(unsortable).sorted() << ' ';
+        ranges::copy(delimited_output::views::delimited(unsortable, delimiters{.sorted = true}), ostreambuf_iterator<char>(cout));
+        cout << endl;
+        cout << delimited(names).sorted(2).as_sub() << endl;
+        auto numbers = unordered_set<int>{};
+        for (int i = 0; i < 200; ++i)
+            numbers.insert((i * 7919) % 1000 - 500);
+        auto sorted_numbers = vector<int>(numbers.begin(), numbers.end());
+        sort(sorted_numbers.begin(), sorted_numbers.end());
+        stringstream a, b;
+        a << delimited(numbers).sorted();
+        b << delimited(sorted_numbers);
+        cout << (a.str() == b.str() ? "radix sorted" : "radix sort failed") << endl;
+        cout << delimited(unordered_map<long, vector<int>>{}).sorted() << endl;
+        cout << delimited(unordered_map<long, vector<int>>{{-1, {1}}, {1, {}}}).sorted().as_sub() << endl;
+    }
+    {
+        cout << endl;
+        cout << delimited(vector<optional<int>>{1, nullopt, 3}) << endl;
+        cout << delimited(optional<vector<int>>{{1, 2}}).as_sub() << endl;
+        cout << delimited(optional<vector<int>>{}).none("-") << endl;
+        using value = variant<int, string, vector<double>, pair<int, int>>;
+        auto values = map<string, value>{{"a", 1}, {"b", string{"Two"}}, {"c", vector<double>{3.5, 4}}, {"d", pair{5, 6}}};
+        cout << delimited(values) << endl;
+        cout << delimited(value{pair{7, 8}}) << endl;
+        cout << delimited(tuple<optional<string>, variant<monostate, int>>{}) << endl;
+    }
+    {
+        cout << endl;
+        cout << delimited(point{1, 2}) << endl;
+        cout << delimited(vector<point>{{1, 2}, {3, 4}}) << endl;
+        cout << delimited(order{"bolt", {5, 6}, {10, 20}}).as_sub() << endl;
+        cout << delimited(vector<labeled>{{1}, {2}}) << endl;
+        cout << delimited(range_bounds{3, 7}) << endl;
+        cout << delimited(map<string, point>{{"a", {0, 0}}, {"bc", {10, -5}}}).table() << endl;
+        cout << delimited_diff(point{1, 2}, point{1, 3}) << endl;
+        auto sink_out = ostringstream{};
+        {
+            auto sink = async_sink{sink_out};
+            sink.write(vector<point>{{5, 6}});
+        }
+        cout << sink_out.str();
+    }
+    {
+        cout << endl;
+        auto position = array<double, 3>{1.5, -2.25, 1e-9};
+        cout << delimited(position) << endl;
+        cout << setprecision(3) << delimited(position).as_sub() << setprecision(6) << endl;
+        int c_array[] = {-2147483647 - 1, 0, 2147483647};
+        cout << delimited(c_array).delimiter("|") << endl;
+        auto values = vector<long long>{1, 2, 3, 4, 5};
+        cout << delimited(span<const long long, 4>{values.data(), 4}) << endl;
+        cout << delimited(position).delimiter(" ---------- ") << endl;
+        cout << delimited(vector<array<short, 2>>{{1, 2}, {3, 4}}) << endl;
+        auto id = array<unsigned char, 4>{'a', 'b', 'c', 'd'};
+        cout << delimited(id).delimiter("") << endl;
+    }
+    {
+        cout << endl;
+        auto readings = vector<int>(1000);
+        for (int i = 0; i < 1000; ++i)
+            readings[i] = i * 10;
+        char payload[32];
+        auto result = delimited_format_to_n(payload, size(payload), readings);
+        cout << string_view{payload, result.size} << " (" << result.size << (result.truncated ? ", truncated)" : ")") << endl;
+        auto size = delimited_formatted_size<char>(readings);
+        ostringstream full;
+        full << delimited(readings);
+        cout << size << ' ' << (size == full.str().size() ? "matches" : "differs") << endl;
+        auto small = map<int, string>{{1, "One"}, {2, ""}};
+        result = delimited_format_to_n(payload, delimited_formatted_size<char>(small), small);
+        cout << string_view{payload, result.size} << (result.truncated ? " (truncated)" : "") << endl;
+        int visited = 0;
+        auto counted = readings | std::views::transform([&](int x) {++visited; return x;});
+        result = delimited_format_to_n(payload, 20, counted, delimiters{});
+        cout << string_view{payload, result.size} << " (" << visited << " elements visited)" << endl;
+    }
+    {
+        cout << endl;
+        constexpr auto ids = delimited_static<array{3, -20, 100}>();
+        static_assert(ids.view() == "3, -20, 100");
+        cout << ids.view() << endl;
+        constexpr auto table = delimited_static([] {return array{pair{1, "One"}, pair{2, ""}};});
+        cout << table.view() << " (" << table.size() << ')' << endl;
+        constexpr auto grid = delimited_static([] {return array{array{1, 2}, array{3, 4}};}, [] {auto d = basic_delimiters<char>{}; d.top_delim = "; "; d.sub_delim = " "; return d;});
+        cout << grid.view() << endl;
+    }
+    {
+        cout << endl;
+        auto formatter = delimited_formatter<vector<pair<int, double>>>{};
+        auto ticks = vector<pair<int, double>>{};
+        for (int i = 1; i <= 3; ++i) {
+            ticks.emplace_back(i, i / 4.0);
+            cout << formatter.format(ticks) << endl;
+        }
+        formatter.stream() << fixed << setprecision(2);
+        cout << formatter.format(ticks) << endl;
+        auto table_formatter = basic_delimited_formatter<map<int, string>, char>{basic_delimiters<char>{.top_as_sub = true}};
+        cout << table_formatter.format({{1, "One"}, {2, ""}}) << endl;
+    }
+    {
+        cout << endl;
+        auto levels = vector<int>{1, 2, 3};
+        auto states = map<int, string>{{1, "idle"}};
+        auto last_levels = delimited_last_output{}, last_states = delimited_last_output{};
+        for (int i = 0; i < 6; ++i) {
+            if (i == 2)
+                levels[1] = 20;
+            if (i == 4)
+                states[1] = "busy";
+            if (delimited_if_changed(last_levels, cout, levels))
+                cout << " (" << i << ')' << endl;
+            if (delimited_if_changed(last_states, cout, states))
+                cout << " (" << i << ')' << endl;
+        }
+        auto last_again = delimited_last_output{};
+        for (int i = 0; i < 2; ++i)
+            if (delimited_if_changed(last_again, cout, levels)) // (a separate last output)
+                cout << " (again)" << endl;
+        last_levels.reset();
+        if (delimited_if_changed(last_levels, cout, levels))
+            cout << " (reset)" << endl;
+    }
 }
@@ -3,15 +3,73 @@
 // program; see: http://gcc.gnu.org/ml/gcc-bugs/2006-05/msg01196.html)
 
 #include "delimited_output.hpp"
+#include "delimited_async.hpp"
 
 #include <iostream>
 #include <algorithm>
 #include <vector>
 #include <array>
+#include <span>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <list>
+#include <deque>
+#include <iomanip>
+#include <iterator>
 #include <tuple>
+#include <optional>
+#include <variant>
 #include <string>
 #include <sstream>
+#include <thread>
+
+namespace {
+
+// (output field by field)
+struct point {
+    int x;
+    int y;
+};
+
+struct order {
+    std::wstring item;
+    point where;
+    std::vector<int> quantities;
+};
+
+// (output via its stream insertion operator, not field by field)
+struct labeled {
+    int value;
+    bool operator==(const labeled&) const = default; // (and hashable, but no <)
+};
+
+std::wostream& operator<<(std::wostream& out, const labeled& l) {
+    return out << L"#" << l.value;
+}
+
+// (tuple-like, via tuple_size and get)
+class range_bounds {
+    int low_, high_;
+public:
+    range_bounds(int low, int high): low_{low}, high_{high} {}
+    template <std::size_t I> int get() const {return I == 0 ? low_ : high_;}
+};
+
+template <std::size_t I>
+int get(const range_bounds& r) {
+    return r.get<I>();
+}
+
+}
+
+template <> struct std::hash<labeled> {
+    std::size_t operator()(const labeled& l) const noexcept {return std::hash<int>{}(l.value);}
+};
+
+template <> struct std::tuple_size<range_bounds>: std::integral_constant<std::size_t, 2> {};
+template <std::size_t I> struct std::tuple_element<I, range_bounds> {using type = int;};
 
 int main() {
     using namespace std;
@@ -138,4 +196,352 @@ int main() {
         };
         wcout << delimited<wchar_t>(seasons).top_delim(L"\n") << endl;
     }
+    {
+        wcout << endl;
+        auto a_map = map<int, const char*>{{1, "One"}, {2, "Two"}, {4, "Four"}};
+        wcout << wdelimited(a_map).prefetch(2) << endl;
+        auto a_list = list{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        wcout << wdelimited(a_list).prefetch(4).as_sub() << endl;
+        wcout << wdelimited(list<int>{}).prefetch(4) << endl;
+        auto tested = 0;
+        auto odd = a_list | std::views::filter([&](int i) {++tested; return i % 2;});
+        wcout << wdelimited(odd).prefetch(4) << ' ' << tested << endl; // (a view isn't prefetched)
+    }
+    {
+        wcout << endl;
+        auto doubles = vector{1.5, -2.25, 1e20, 3.14159265, 0.0};
+        wcout << wdelimited(doubles) << endl;
+        wcout << setprecision(3) << wdelimited(doubles) << setprecision(6) << endl;
+        wcout << fixed << wdelimited(doubles) << defaultfloat << endl;
+        wcout << showpos << wdelimited(array{1, -2, 3}) << noshowpos << endl;
+        wcout << setw(4) << wdelimited(array{1, -2, 3}) << endl;
+        auto ints = deque<int>{};
+        auto strs = deque<wstring>{};
+        for (int i = 0; i < 1000; ++i) {
+            ints.push_front(i);
+            strs.push_back(i % 7 ? to_wstring(i) : wstring{});
+        }
+        wstringstream ss1, ss2;
+        ss1 << wdelimited(ints) << wdelimited(strs);
+        ss2 << wdelimited(vector(ints.begin(), ints.end())) << wdelimited(vector(strs.begin(), strs.end()));
+        wcout << (ss1.str() == ss2.str() ? L"deque output matches vector output" : L"deque output differs from vector output") << endl;
+        wcout << wdelimited(deque(ints.begin() + 990, ints.end())).as_sub() << endl;
+    }
+    {
+        wcout << endl;
+        auto vectors = vector<vector<int>>{{1, 2, 3}, {}, {4, 5}};
+        ranges::copy(delimited_output::views::wdelimited(vectors), ostreambuf_iterator<wchar_t>(wcout));
+        wcout << endl;
+        auto a_map = map<int, wstring>{{1, L"One"}, {2, L"Two"}, {3, L"Three"}};
+        auto delims = wdelimiters{};
+        delims.top_as_sub = true;
+        auto view = delimited_output::views::delimited(a_map, delims);
+        for (auto chunk: view.chunks())
+            wcout << '<' << chunk << '>';
+        wcout << endl;
+        wcout << ranges::count(delimited_output::views::wdelimited(vectors), ',') << endl;
+    }
+    {
+        wcout << endl;
+        auto ints = vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        auto is_odd = [](int i) {return i % 2 != 0;};
+        wcout << wdelimited(ints | std::views::filter(is_odd)) << endl;
+        auto evens = ints | std::views::filter([](int i) {return i % 2 == 0;});
+        wcout << wdelimited(evens).as_sub() << endl;
+        auto rows = vector<vector<int>>{{1, 2, 3}, {4, 5}, {6}};
+        wcout << wdelimited(rows | std::views::transform([&](const vector<int>& row) {return row | std::views::filter(is_odd);})) << endl;
+        auto in = wistringstream{L"10 20 30"};
+        wcout << wdelimited(std::views::istream<int>(in)).delimiter(L" + ") << endl;
+        ranges::copy(delimited_output::views::wdelimited(ints | std::views::filter(is_odd)), ostreambuf_iterator<wchar_t>(wcout));
+        wcout << endl;
+    }
+    {
+        wcout << endl;
+        {
+            auto sink = wasync_sink{wcout};
+            sink.write(vector<int>{1, 2, 3});
+            sink.write(map<int, wstring>{{1, L"One"}, {2, L""}});
+            sink.write(list<pair<wstring, vector<double>>>{{L"a", {1.5, 2}}, {L"b", {}}});
+            auto delims = wdelimiters{};
+            delims.top_delim = L" | ";
+            sink.write(tuple{1, L"Two", L'3'}, delims);
+            sink.flush();
+            sink.write(deque<int>{});
+        }
+        auto out = wstringstream{};
+        {
+            auto sink = wasync_sink{out, 4096};
+            auto threads = vector<thread>{};
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&sink, t] {
+                    for (int i = 0; i < 1000; ++i)
+                        sink.write(vector<int>(i % 20, t));
+                });
+            for (auto& th: threads)
+                th.join();
+        }
+        int records = 0, torn = 0;
+        for (wstring line; getline(out, line); ++records) {
+            auto t = line.empty() ? L'?' : line[0];
+            torn += line != L"<empty>" && line.find_first_not_of(wstring{t, L',', L' '}) != wstring::npos;
+        }
+        wcout << records << L" records, " << torn << L" torn" << endl;
+    }
+    {
+        wcout << endl;
+        {
+            auto sink = wshared_sink{wcout};
+            sink.write(vector<int>{1, 2, 3});
+            sink.write(wdelimited(map<int, wstring>{{1, L"One"}, {2, L"Two"}}).pair_delim(L"=").as_sub());
+            sink.flush();
+            sink.write(list<double>{});
+        }
+        auto out = wstringstream{};
+        {
+            auto sink = wshared_sink{out, 4096};
+            auto threads = vector<thread>{};
+            for (int t = 0; t < 4; ++t)
+                threads.emplace_back([&sink, t] {
+                    for (int i = 0; i < 1000; ++i)
+                        sink.write(vector<int>(i % 20, t));
+                });
+            for (auto& th: threads)
+                th.join();
+        }
+        int records = 0, torn = 0;
+        for (wstring line; getline(out, line); ++records) {
+            auto t = line.empty() ? L'?' : line[0];
+            torn += line != L"<empty>" && line.find_first_not_of(wstring{t, L',', L' '}) != wstring::npos;
+        }
+        wcout << records << L" records, " << torn << L" torn" << endl;
+    }
+    {
+        wcout << endl;
+        auto a_map = map<int, wstring>{{1, L"One"}, {2, L"Two"}, {3, L""}};
+        wcout << wdelimited(a_map).atomic().terminator(L"\n");
+        wcout << wdelimited(a_map).terminator(L" (not atomic)\n");
+        auto doubles = vector<double>{1.23456, 2.5, 1e-7};
+        wstringstream ss1, ss2;
+        ss1 << setprecision(3) << showpos << setw(8) << left << setfill(L'*') << wdelimited(doubles) << L'|';
+        ss2 << setprecision(3) << showpos << setw(8) << left << setfill(L'*') << wdelimited(doubles).atomic() << L'|';
+        wcout << ss1.str() << endl << (ss1.str() == ss2.str() ? L"atomic output matches" : L"atomic output differs") << endl;
+        struct counting_buf: wstreambuf {
+            int writes = 0;
+            int_type overflow(int_type c) override {++writes; return c;}
+            streamsize xsputn(const wchar_t*, streamsize n) override {++writes; return n;}
+        } buf;
+        wostream out{&buf};
+        out << wdelimited(a_map);
+        auto writes = buf.writes;
+        buf.writes = 0;
+        out << wdelimited(a_map).atomic().terminator(L"\n");
+        wcout << writes << L" writes, " << buf.writes << L" atomic" << endl;
+    }
+    {
+        wcout << endl;
+        auto ages = map<wstring, int>{{L"Alice", 30}, {L"Bob", 4}, {L"Carol", 120}};
+        wcout << wdelimited(ages).table() << endl;
+        wcout << right << wdelimited(ages).table(L" | ", L"\n") << left << endl;
+        auto rows = vector<tuple<int, wstring, vector<int>>>{{1, L"One", {1}}, {22, L"", {}}, {333, L"Three", {1, 2, 3}}};
+        wcout << wdelimited(rows).table() << endl;
+        auto ragged = vector<vector<double>>{{1.5, 2}, {}, {3, 4.25, 5}};
+        wcout << wdelimited(ragged).table() << endl;
+        wcout << wdelimited(vector<vector<int>>{}).table() << endl;
+    }
+    {
+        wcout << endl;
+        auto cache = wdelimited_cache{};
+        auto config = map<wstring, int>{{L"retries", 3}, {L"timeout", 30}};
+        std::uint64_t version = 1;
+        wcout << cached_delimited(cache, config, version) << endl;
+        config[L"timeout"] = 60; // (not output, as the version is unchanged)
+        wcout << cached_delimited(cache, config, version) << endl;
+        ++version;
+        wcout << cached_delimited(cache, config, version) << endl;
+        auto delims = wdelimiters{};
+        delims.top_delim = L"; ";
+        wcout << cached_delimited(cache, config, version, delims) << endl;
+        delims.terminator = L" (terminated)\n";
+        wcout << cached_delimited(cache, config, version, delims);
+        wcout << cached_delimited(cache, config, version, delims); // (from the cache, with the terminator)
+        wcout << setw(10) << cached_delimited(cache, config.begin()->first, 0) << L'|' << endl;
+        wcout << cached_delimited(cache, config.begin()->first, 0) << L'|' << endl;
+        wcout << cache.size() << L" cached" << endl;
+    }
+    {
+        wcout << endl;
+        auto events = vector<pair<int, wstring>>{};
+        auto appender = wdelimited_appender{};
+        wstringstream appended;
+        for (int tick = 0; tick < 4; ++tick) {
+            for (int i = 0; i < tick; ++i)
+                events.emplace_back(tick, i % 2 ? L"odd" : L"");
+            auto chunk = wstringstream{};
+            chunk << appender(events);
+            wcout << L'<' << chunk.str() << L'>';
+            appended << chunk.str();
+        }
+        wcout << endl << appender.count() << endl;
+        wstringstream full;
+        full << wdelimited(events);
+        wcout << (appended.str() == full.str() ? L"appended output matches" : L"appended output differs") << endl;
+        auto delims = wdelimiters{};
+        delims.top_delim = L" / ";
+        auto list_appender = wdelimited_appender{delims};
+        auto a_list = list<vector<int>>{{1, 2}};
+        wcout << list_appender(a_list);
+        a_list.push_back({});
+        a_list.push_back({3});
+        wcout << list_appender(a_list) << endl;
+    }
+    {
+        wcout << endl;
+        wcout << wdelimited_diff(vector<int>{1, 2, 3}, vector<int>{1, 5}) << endl;
+        wcout << wdelimited_diff(map<int, wstring>{{1, L"a"}, {2, L"b"}}, map<int, wstring>{{2, L"c"}, {3, L"d"}}) << endl;
+        wcout << wdelimited_diff(set<int>{1, 3, 5, 7}, set<int>{1, 4, 5}) << endl;
+        wcout << wdelimited_diff(list<wstring>{L"x", L"y"}, list<wstring>{L"x", L"z", L"w"}) << endl;
+        wcout << wdelimited_diff(make_tuple(1, wstring{L"same"}, 2.5), make_tuple(1, wstring{L"other"}, 2.5)) << endl;
+        auto before = vector<int>(1000);
+        for (int i = 0; i < 1000; ++i)
+            before[i] = i;
+        auto after = before;
+        after[700] = -1;
+        after.push_back(1000);
+        wcout << wdelimited_diff(before, after) << endl;
+        wcout << wdelimited_diff(before, before) << endl;
+        auto delims = wdelimiters{};
+        delims.top_delim = L"; ";
+        delims.sub_prefix = L"";
+        delims.sub_delim = L" ";
+        delims.sub_suffix = L"";
+        wcout << delimited_diff(vector<vector<int>>{{1}, {2, 3}}, vector<vector<int>>{{1}, {2}}, delims) << endl;
+    }
+    {
+        wcout << endl;
+        auto names = unordered_map<wstring, int>{{L"Carol", 3}, {L"Alice", 1}, {L"Bob", 2}, {L"Dave", 4}};
+        wcout << wdelimited(names).sorted() << endl;
+        ranges::copy(delimited_output::views::delimited(names, wdelimiters{.sorted = true}), ostreambuf_iterator<wchar_t>(wcout));
+        wcout << endl;
+        auto unsortable = unordered_set<labeled>{{7}}; // (no <, so output in hash order)
+        wcout << wdelimited(unsortable).sorted() << ' ';
+        ranges::copy(delimited_output::views::delimited(unsortable, wdelimiters{.sorted = true}), ostreambuf_iterator<wchar_t>(wcout));
+        wcout << endl;
+        wcout << wdelimited(names).sorted(2).as_sub() << endl;
+        auto numbers = unordered_set<int>{};
+        for (int i = 0; i < 200; ++i)
+            numbers.insert((i * 7919) % 1000 - 500);
+        auto sorted_numbers = vector<int>(numbers.begin(), numbers.end());
+        sort(sorted_numbers.begin(), sorted_numbers.end());
+        wstringstream a, b;
+        a << wdelimited(numbers).sorted();
+        b << wdelimited(sorted_numbers);
+        wcout << (a.str() == b.str() ? L"radix sorted" : L"radix sort failed") << endl;
+        wcout << wdelimited(unordered_map<long, vector<int>>{}).sorted() << endl;
+        wcout << wdelimited(unordered_map<long, vector<int>>{{-1, {1}}, {1, {}}}).sorted().as_sub() << endl;
+    }
+    {
+        wcout << endl;
+        wcout << wdelimited(vector<optional<int>>{1, nullopt, 3}) << endl;
+        wcout << wdelimited(optional<vector<int>>{{1, 2}}).as_sub() << endl;
+        wcout << wdelimited(optional<vector<int>>{}).none(L"-") << endl;
+        using value = variant<int, wstring, vector<double>, pair<int, int>>;
+        auto values = map<wstring, value>{{L"a", 1}, {L"b", wstring{L"Two"}}, {L"c", vector<double>{3.5, 4}}, {L"d", pair{5, 6}}};
+        wcout << wdelimited(values) << endl;
+        wcout << wdelimited(value{pair{7, 8}}) << endl;
+        wcout << wdelimited(tuple<optional<wstring>, variant<monostate, int>>{}) << endl;
+    }
+    {
+        wcout << endl;
+        wcout << wdelimited(point{1, 2}) << endl;
+        wcout << wdelimited(vector<point>{{1, 2}, {3, 4}}) << endl;
+        wcout << wdelimited(order{L"bolt", {5, 6}, {10, 20}}).as_sub() << endl;
+        wcout << wdelimited(vector<labeled>{{1}, {2}}) << endl;
+        wcout << wdelimited(range_bounds{3, 7}) << endl;
+        wcout << wdelimited(map<wstring, point>{{L"a", {0, 0}}, {L"bc", {10, -5}}}).table() << endl;
+        wcout << wdelimited_diff(point{1, 2}, point{1, 3}) << endl;
+        auto sink_out = wostringstream{};
+        {
+            auto sink = wasync_sink{sink_out};
+            sink.write(vector<point>{{5, 6}});
+        }
+        wcout << sink_out.str();
+    }
+    {
+        wcout << endl;
+        auto position = array<double, 3>{1.5, -2.25, 1e-9};
+        wcout << wdelimited(position) << endl;
+        wcout << setprecision(3) << wdelimited(position).as_sub() << setprecision(6) << endl;
+        int c_array[] = {-2147483647 - 1, 0, 2147483647};
+        wcout << wdelimited(c_array).delimiter(L"|") << endl;
+        auto values = vector<long long>{1, 2, 3, 4, 5};
+        wcout << wdelimited(span<const long long, 4>{values.data(), 4}) << endl;
+        wcout << wdelimited(position).delimiter(L" ---------- ") << endl;
+        wcout << wdelimited(vector<array<short, 2>>{{1, 2}, {3, 4}}) << endl;
+    }
+    {
+        wcout << endl;
+        auto readings = vector<int>(1000);
+        for (int i = 0; i < 1000; ++i)
+            readings[i] = i * 10;
+        wchar_t payload[32];
+        auto result = delimited_format_to_n(payload, size(payload), readings);
+        wcout << wstring_view{payload, result.size} << L" (" << result.size << (result.truncated ? L", truncated)" : L")") << endl;
+        auto size = delimited_formatted_size<wchar_t>(readings);
+        wostringstream full;
+        full << wdelimited(readings);
+        wcout << size << L' ' << (size == full.str().size() ? L"matches" : L"differs") << endl;
+        auto small = map<int, wstring>{{1, L"One"}, {2, L""}};
+        result = delimited_format_to_n(payload, delimited_formatted_size<wchar_t>(small), small);
+        wcout << wstring_view{payload, result.size} << (result.truncated ? L" (truncated)" : L"") << endl;
+        int visited = 0;
+        auto counted = readings | std::views::transform([&](int x) {++visited; return x;});
+        result = delimited_format_to_n(payload, 20, counted, wdelimiters{});
+        wcout << wstring_view{payload, result.size} << L" (" << visited << L" elements visited)" << endl;
+    }
+    {
+        wcout << endl;
+        constexpr auto ids = delimited_static<array{3, -20, 100}, wchar_t>();
+        static_assert(ids.view() == L"3, -20, 100");
+        wcout << ids.view() << endl;
+        constexpr auto table = delimited_static<wchar_t>([] {return array{pair{1, L"One"}, pair{2, L""}};});
+        wcout << table.view() << " (" << table.size() << ')' << endl;
+        constexpr auto grid = delimited_static([] {return array{array{1, 2}, array{3, 4}};}, [] {auto d = basic_delimiters<wchar_t>{}; d.top_delim = L"; "; d.sub_delim = L" "; return d;});
+        wcout << grid.view() << endl;
+    }
+    {
+        wcout << endl;
+        auto formatter = wdelimited_formatter<vector<pair<int, double>>>{};
+        auto ticks = vector<pair<int, double>>{};
+        for (int i = 1; i <= 3; ++i) {
+            ticks.emplace_back(i, i / 4.0);
+            wcout << formatter.format(ticks) << endl;
+        }
+        formatter.stream() << fixed << setprecision(2);
+        wcout << formatter.format(ticks) << endl;
+        auto table_formatter = basic_delimited_formatter<map<int, wstring>, wchar_t>{basic_delimiters<wchar_t>{.top_as_sub = true}};
+        wcout << table_formatter.format({{1, L"One"}, {2, L""}}) << endl;
+    }
+    {
+        wcout << endl;
+        auto levels = vector<int>{1, 2, 3};
+        auto states = map<int, wstring>{{1, L"idle"}};
+        auto last_levels = delimited_last_output{}, last_states = delimited_last_output{};
+        for (int i = 0; i < 6; ++i) {
+            if (i == 2)
+                levels[1] = 20;
+            if (i == 4)
+                states[1] = L"busy";
+            if (delimited_if_changed(last_levels, wcout, levels))
+                wcout << " (" << i << ')' << endl;
+            if (delimited_if_changed(last_states, wcout, states))
+                wcout << " (" << i << ')' << endl;
+        }
+        auto last_again = delimited_last_output{};
+        for (int i = 0; i < 2; ++i)
+            if (delimited_if_changed(last_again, wcout, levels)) // (a separate last output)
+                wcout << " (again)" << endl;
+        last_levels.reset();
+        if (delimited_if_changed(last_levels, wcout, levels))
+            wcout << " (reset)" << endl;
+    }
 }
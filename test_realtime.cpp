@@ -0,0 +1,80 @@
+// test realtime::delimited_format_to_n() built with exceptions disabled (see
+// the Makefile), checking that it doesn't allocate
+
+#include "delimited_output.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <array>
+#include <map>
+#include <tuple>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// (operator new below allocates from this arena, never reusing it, and counts)
+alignas(std::max_align_t) char arena[1 << 20];
+std::size_t arena_used = 0;
+std::size_t allocations = 0;
+
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    auto offset = (arena_used + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    if (size > sizeof arena - offset)
+        std::abort();
+    arena_used = offset + size;
+    return arena + offset;
+}
+
+void operator delete(void*) noexcept {}
+void operator delete(void*, std::size_t) noexcept {}
+
+int main() {
+    using namespace std;
+    using namespace delimited_output;
+
+    auto levels = vector<double>{0.5, -1.25, 1e-9, 3};
+    auto params = map<int, tuple<string, bool, optional<float>>>{{1, {"gain", true, 0.75f}}, {2, {"", false, nullopt}}};
+    auto channels = array<array<int, 2>, 3>{{{1, 2}, {3, 4}, {5, 6}}};
+    auto delims = delimiters{};
+    delims.top_delim = " | ";
+    delims.top_as_sub = true;
+
+    char line[64];
+    static_assert(noexcept(realtime::delimited_format_to_n(line, sizeof line, levels)));
+    auto before = allocations;
+    auto r1 = realtime::delimited_format_to_n(line, sizeof line, levels);
+    auto s1 = string_view{line, r1.size};
+    char line2[64];
+    auto r2 = realtime::delimited_format_to_n(line2, sizeof line2, params);
+    auto s2 = string_view{line2, r2.size};
+    char line3[64];
+    auto r3 = realtime::delimited_format_to_n(line3, sizeof line3, channels, delims);
+    auto s3 = string_view{line3, r3.size};
+    char line4[10];
+    auto r4 = realtime::delimited_format_to_n(line4, sizeof line4, levels);
+    auto s4 = string_view{line4, r4.size};
+    auto allocated = allocations - before;
+
+    cout << s1 << (r1.truncated ? " (truncated)" : "") << endl;
+    cout << s2 << (r2.truncated ? " (truncated)" : "") << endl;
+    cout << s3 << (r3.truncated ? " (truncated)" : "") << endl;
+    cout << s4 << (r4.truncated ? " (truncated)" : "") << endl;
+    cout << "allocations: " << allocated << endl;
+
+    // (the same as delimited() with default formatting)
+    auto same = [&](const auto& obj, string_view text, const delimiters& d = {}) {
+        auto full = string{};
+        full.resize(delimited_formatted_size(obj, d));
+        delimited_format_to_n(full.data(), full.size(), obj, d);
+        return full == text;
+    };
+    cout << (same(levels, s1) && same(params, s2) && same(channels, s3, delims) ? "same as delimited()" : "differs from delimited()") << endl;
+}